@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "crypto/cpu.hpp"
 #include "crypto/rnd.hpp"
 #include "crypto/sha2_256.hpp"
 #include "crypto/sha2_512.hpp"
@@ -17,6 +18,10 @@
 #include "crypto/poly1305.hpp"
 #include "crypto/chaCha.hpp"
 #include "crypto/chaCha20Poly1305.hpp"
+#include "crypto/chaCha20Poly1305Session.hpp"
+#include "crypto/chaCha20Poly1305Stream.hpp"
+#include "crypto/aesGcm.hpp"
+#include "crypto/encryptedFile.hpp"
 
 #include "crypto/curve25519.hpp"
 #include "crypto/ed25519.hpp"
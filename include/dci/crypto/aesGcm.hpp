@@ -0,0 +1,52 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/himpl.hpp>
+#include <dci/crypto/implMetaInfo.hpp>
+#include "api.hpp"
+
+namespace dci::crypto
+{
+    // aes-gcm aead (nist sp 800-38d) with 16 byte tags, the same shape as ChaCha20Poly1305; aes-ni
+    // rounds and pclmul ghash where the cpu has them. The portable fallback uses sbox table lookups
+    // and is not constant time against cache timing; where cpu::activeKernels() does not report
+    // "aesni" for "aesGcm", prefer ChaCha20Poly1305 when negotiating a cipher
+    class API_DCI_CRYPTO AesGcm
+        : public himpl::FaceLayout<AesGcm, impl::AesGcm>
+    {
+    public:
+        AesGcm();
+        AesGcm(const AesGcm&);
+        AesGcm(AesGcm&&);
+
+        AesGcm& operator=(const AesGcm&);
+        AesGcm& operator=(AesGcm&&);
+
+        ~AesGcm();
+
+    public:
+        // 16, 24 or 32 bytes
+        void setKey(const void* key, std::size_t len);
+        void setAd(const void* ad, std::size_t len);
+
+        // 12 bytes is the usual, other lengths are hashed into the initial counter
+        void start(const void* nonce, std::size_t len);
+
+        // a message is at most 2^32-2 blocks (64 GiB less 32 bytes), past that the 32 bit counter
+        // would wrap to the one masking the tag; a span that would cross it is refused untouched
+        // with false, and decipherFinish of that message fails
+        bool encipher(const void* in, void* out, std::size_t len);
+        void encipherFinish(void* macOut);
+
+        bool decipher(const void* in, void* out, std::size_t len);
+        bool decipherFinish(const void* macIn);
+
+        void clear();
+    };
+}
@@ -11,6 +11,7 @@
 #include <dci/crypto/implMetaInfo.hpp>
 #include "api.hpp"
 #include "streamCipher.hpp"
+#include "chaChaJob.hpp"
 
 namespace dci::crypto
 {
@@ -31,6 +32,14 @@ namespace dci::crypto
         void setKey(const void* key, std::size_t len);
         void setIv(const void* iv, std::size_t len);
         void cipher(const void* in, void* out, std::size_t len);
+
+        // same result and resulting stream position as cipher, large inputs are split by block
+        // counter across up to workers threads (0 - one per hardware thread)
+        void cipherParallel(const void* in, void* out, std::size_t len, std::size_t workers = 0);
+
+        // many short independent streams at once, one stream per simd lane
+        static void cipherBatch(const ChaChaJob* jobs, std::size_t count, std::size_t rounds = 20);
+
         void seek(std::uint64_t offset);
         void clear();
     };
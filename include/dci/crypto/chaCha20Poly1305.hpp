@@ -10,6 +10,9 @@
 #include <dci/himpl.hpp>
 #include <dci/crypto/implMetaInfo.hpp>
 #include "api.hpp"
+#include "iov.hpp"
+#include "chaCha20Poly1305Packet.hpp"
+#include <cstdint>
 
 namespace dci::crypto
 {
@@ -32,12 +35,49 @@ namespace dci::crypto
 
         void start(const void* nonce, std::size_t len);
 
+        // associated data straight into the mac, without the copy setAd keeps; between start and
+        // the first encipher/decipher, appends to whatever setAd gave
+        void addAd(const void* ad, std::size_t len);
+
         void encipher(const void* in, void* out, std::size_t len);
         void encipherFinish(void* macOut);
 
         void decipher(const void* in, void* out, std::size_t len);
         bool decipherFinish(const void* macIn);
 
+        // the whole remaining ciphertext at once instead of decipher/decipherFinish: the mac is
+        // checked first and keystream is spent only on an authentic message, out is not written
+        // otherwise
+        bool decipherVerified(const void* in, void* out, std::size_t len, const void* macIn);
+
         void clear();
+
+    public:
+        // whole message in one call, no object state; in and out may be split into pieces
+        // differently but must add up to the same length, out may be the same memory as in
+        static void seal(
+            const void* key, std::size_t keyLen,
+            const void* nonce, std::size_t nonceLen,
+            const void* ad, std::size_t adLen,
+            const ConstIov* in, std::size_t inCount,
+            const Iov* out, std::size_t outCount,
+            void* macOut);
+
+        // verifies before deciphering, false and out not written on a wrong mac
+        static bool open(
+            const void* key, std::size_t keyLen,
+            const void* nonce, std::size_t nonceLen,
+            const void* ad, std::size_t adLen,
+            const ConstIov* in, std::size_t inCount,
+            const Iov* out, std::size_t outCount,
+            const void* macIn);
+
+        // many messages under one key at once, packets spread over simd lanes of chacha and
+        // poly1305; 12 and 24 byte nonces take the batched path, others go one by one
+        static void sealBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count);
+
+        // bit i of valid (count/64 rounded up words) tells whether packet i is authentic, out of
+        // a forged packet gets no plaintext; returns the number of authentic packets
+        static std::size_t openBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count, std::uint64_t* valid);
     };
 }
@@ -0,0 +1,53 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/himpl.hpp>
+#include <dci/crypto/implMetaInfo.hpp>
+#include "api.hpp"
+#include <cstdint>
+
+namespace dci::crypto
+{
+    // ietf chacha20-poly1305 over a sequence of messages under one key, message n goes under the
+    // 12 byte nonce of the 4 byte prefix followed by n as 8 little endian bytes (as in wireguard);
+    // poly1305 keys for the next few messages are drawn from the keystream in one go
+    class API_DCI_CRYPTO ChaCha20Poly1305Session
+        : public himpl::FaceLayout<ChaCha20Poly1305Session, impl::ChaCha20Poly1305Session>
+    {
+    public:
+        ChaCha20Poly1305Session();
+        ChaCha20Poly1305Session(const ChaCha20Poly1305Session&);
+        ChaCha20Poly1305Session(ChaCha20Poly1305Session&&);
+
+        ChaCha20Poly1305Session& operator=(const ChaCha20Poly1305Session&);
+        ChaCha20Poly1305Session& operator=(ChaCha20Poly1305Session&&);
+
+        ~ChaCha20Poly1305Session();
+
+    public:
+        void setKey(const void* key, std::size_t len);
+
+        // up to 4 bytes, zero padded; zeros by default
+        void setNoncePrefix(const void* prefix, std::size_t len);
+
+        // number of the next message
+        void setCounter(std::uint64_t counter);
+        std::uint64_t counter() const;
+
+        // next message, the counter moves on; false and nothing written once the counter reached
+        // 2^64-1, the one value never used, so a nonce can not come round again
+        bool seal(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, void* macOut);
+
+        // next message, verified before deciphering; the counter moves on only for an authentic
+        // one, out is not written otherwise; false once the counter reached 2^64-1, as for seal
+        bool open(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, const void* macIn);
+
+        void clear();
+    };
+}
@@ -0,0 +1,73 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/himpl.hpp>
+#include <dci/crypto/implMetaInfo.hpp>
+#include "api.hpp"
+#include <cstdint>
+
+namespace dci::crypto
+{
+    // large object as a sequence of independent chacha20-poly1305 chunks (the STREAM
+    // construction): chunk i of chunkSize plaintext bytes, the last one possibly shorter, is sealed
+    // under the 12 byte nonce of the 7 byte prefix, i as 4 big endian bytes and a byte 1 for the
+    // last chunk or 0 otherwise, with the ad; a sealed chunk is its ciphertext followed by the mac.
+    // Chunks of one call go in parallel, each is verified on its own so a reader releases
+    // plaintext as the chunks arrive, truncation and reordering are caught by the nonces
+    class API_DCI_CRYPTO ChaCha20Poly1305Stream
+        : public himpl::FaceLayout<ChaCha20Poly1305Stream, impl::ChaCha20Poly1305Stream>
+    {
+    public:
+        static constexpr std::size_t macSize = 16;
+
+    public:
+        ChaCha20Poly1305Stream();
+        ChaCha20Poly1305Stream(const ChaCha20Poly1305Stream&);
+        ChaCha20Poly1305Stream(ChaCha20Poly1305Stream&&);
+
+        ChaCha20Poly1305Stream& operator=(const ChaCha20Poly1305Stream&);
+        ChaCha20Poly1305Stream& operator=(ChaCha20Poly1305Stream&&);
+
+        ~ChaCha20Poly1305Stream();
+
+    public:
+        void setKey(const void* key, std::size_t len);
+        void setAd(const void* ad, std::size_t len);
+        // plaintext bytes per chunk, 64 KiB by default
+        void setChunkSize(std::size_t chunkSize);
+
+        // 0 - one per hardware thread
+        void setWorkers(std::size_t workers);
+
+        // prefix up to 7 bytes, zero padded, unique per object under the key; the chunk counter
+        // goes back to 0
+        void start(const void* prefix, std::size_t len);
+
+        // the next chunk to encipher or decipher, for random access into a sealed object; false
+        // past the 2^32 chunks a nonce can number, the stream is dead then
+        bool seek(std::uint64_t chunk);
+
+        // whole chunks of plaintext, len a multiple of the chunk size unless last (the last call
+        // may be empty); out gets len + macSize bytes per chunk. False and nothing written after
+        // the last chunk, on a bad len or past 2^32 chunks (a nonce would repeat), the stream is
+        // dead after that
+        bool encipher(const void* in, std::size_t len, void* out, bool last);
+
+        // whole sealed chunks, len a multiple of chunk size + macSize unless last; out gets the
+        // plaintext of the authentic chunks. False on a forged, reordered or truncated chunk, the
+        // stream is dead after that
+        bool decipher(const void* in, std::size_t len, void* out, bool last);
+
+        void clear();
+
+    public:
+        // an empty object is one empty chunk
+        static std::uint64_t sealedSize(std::uint64_t len, std::size_t chunkSize);
+    };
+}
@@ -0,0 +1,45 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "api.hpp"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dci::crypto::cpu
+{
+    enum class Tier
+    {
+        generic,
+        ssse3,
+        avx2,
+        avx512,
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Tier API_DCI_CRYPTO detectedTier();
+    Tier API_DCI_CRYPTO activeTier();
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // limit kernels to the given tier (clamped to the detected one) and rebind all primitives,
+    // not thread safe against concurrent crypto calls; DCI_CRYPTO_CPU_TIER=generic|ssse3|avx2|avx512
+    // in the environment does the same at load time
+    void API_DCI_CRYPTO forceTier(Tier tier);
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // treat the listed extensions as absent and rebind all primitives, so kernels that a better
+    // extension shadows (avx2 sha-256 on sha-ni hosts) stay testable; comma separated names from
+    // sse2, ssse3, sse41, avx2, bmi2, adx, avx512f, avx512vl, avx512ifma, sha, aesni, pclmul, empty
+    // unmasks all. Not thread safe as forceTier; DCI_CRYPTO_CPU_MASK does the same at load time
+    void API_DCI_CRYPTO maskFeatures(std::string_view names);
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // primitive name -> name of the kernel bound for it
+    std::vector<std::pair<std::string_view, std::string_view>> API_DCI_CRYPTO activeKernels();
+}
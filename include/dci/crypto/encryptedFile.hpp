@@ -0,0 +1,56 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/himpl.hpp>
+#include <dci/crypto/implMetaInfo.hpp>
+#include "api.hpp"
+#include <cstdint>
+
+namespace dci::crypto
+{
+    // file of fixed size chacha20-poly1305 segments for random access reads. A 32 byte header
+    // (magic, segment size, nonce prefix, plaintext size) is all the index there is: segment i
+    // lies at headerSize + i*(segment size + 16), sealed as chunk i of a ChaCha20Poly1305Stream
+    // with the header as ad. The file is memory mapped, a read deciphers and verifies only the
+    // segments it overlaps
+    class API_DCI_CRYPTO EncryptedFile
+        : public himpl::FaceLayout<EncryptedFile, impl::EncryptedFile>
+    {
+    public:
+        static constexpr std::size_t headerSize = 32;
+
+    public:
+        EncryptedFile();
+        EncryptedFile(const EncryptedFile&) = delete;
+        EncryptedFile(EncryptedFile&&);
+
+        EncryptedFile& operator=(const EncryptedFile&) = delete;
+        EncryptedFile& operator=(EncryptedFile&&);
+
+        ~EncryptedFile();
+
+    public:
+        // new file for exactly size plaintext bytes given by write calls in order, the nonce
+        // prefix is random
+        bool create(const char* path, const void* key, std::size_t keyLen, std::uint64_t size, std::size_t segmentSize = 64*1024);
+        bool write(const void* data, std::size_t len);
+
+        // existing file, read only
+        bool open(const char* path, const void* key, std::size_t keyLen);
+
+        std::uint64_t size() const;
+
+        // false if the range is not inside the file or a segment it overlaps is not authentic;
+        // not for concurrent use on one object
+        bool read(std::uint64_t offset, void* out, std::size_t len);
+
+        // false for a created file not written up to its size
+        bool close();
+    };
+}
@@ -11,6 +11,7 @@
 #include <dci/crypto/implMetaInfo.hpp>
 #include "api.hpp"
 #include "hash.hpp"
+#include "sha2_256Job.hpp"
 
 namespace dci::crypto
 {
@@ -20,6 +21,10 @@ namespace dci::crypto
     public:
         static HashPtr alloc(std::size_t digestSize = 32);
 
+        // hashes independent messages several at a time in simd lanes, a lane takes the next job as
+        // soon as its message is done, so uneven lengths keep all lanes busy
+        static void hashBatch(const Sha2_256Job* jobs, std::size_t count);
+
     public:
         Sha2_256(std::size_t digestSize = 32);
         Sha2_256(const Sha2_256&);
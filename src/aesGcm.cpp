@@ -0,0 +1,97 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/crypto/aesGcm.hpp>
+#include "impl/aesGcm.hpp"
+
+namespace dci::crypto
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::AesGcm()
+        : himpl::FaceLayout<AesGcm, impl::AesGcm>()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::AesGcm(const AesGcm& from)
+        : himpl::FaceLayout<AesGcm, impl::AesGcm>(from.impl())
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::AesGcm(AesGcm&& from)
+        : himpl::FaceLayout<AesGcm, impl::AesGcm>(std::move(from.impl()))
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm& AesGcm::operator=(const AesGcm& from)
+    {
+        impl() = from.impl();
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm& AesGcm::operator=(AesGcm&& from)
+    {
+        impl() = std::move(from.impl());
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::~AesGcm()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::setKey(const void* key, std::size_t len)
+    {
+        return impl().setKey(key, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::setAd(const void* ad, std::size_t len)
+    {
+        return impl().setAd(ad, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::start(const void* nonce, std::size_t len)
+    {
+        return impl().start(nonce, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::encipher(const void* in, void* out, std::size_t len)
+    {
+        return impl().encipher(in, out, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::encipherFinish(void* macOut)
+    {
+        return impl().encipherFinish(macOut);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::decipher(const void* in, void* out, std::size_t len)
+    {
+        return impl().decipher(in, out, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::decipherFinish(const void* macIn)
+    {
+        return impl().decipherFinish(macIn);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::clear()
+    {
+        return impl().clear();
+    }
+}
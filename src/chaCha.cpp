@@ -65,6 +65,18 @@ namespace dci::crypto
         return impl().cipher(in, out, len);
     }
 
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha::cipherParallel(const void* in, void* out, std::size_t len, std::size_t workers)
+    {
+        return impl().cipherParallel(in, out, len, workers);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha::cipherBatch(const ChaChaJob* jobs, std::size_t count, std::size_t rounds)
+    {
+        return impl::ChaCha::cipherBatch(jobs, count, rounds);
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void ChaCha::seek(std::uint64_t offset)
     {
@@ -65,6 +65,12 @@ namespace dci::crypto
         return impl().start(nonce, len);
     }
 
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::addAd(const void* ad, std::size_t len)
+    {
+        return impl().addAd(ad, len);
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void ChaCha20Poly1305::encipher(const void* in, void* out, std::size_t len)
     {
@@ -89,9 +95,51 @@ namespace dci::crypto
         return impl().decipherFinish(macIn);
     }
 
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305::decipherVerified(const void* in, void* out, std::size_t len, const void* macIn)
+    {
+        return impl().decipherVerified(in, out, len, macIn);
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void ChaCha20Poly1305::clear()
     {
         return impl().clear();
     }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::seal(
+        const void* key, std::size_t keyLen,
+        const void* nonce, std::size_t nonceLen,
+        const void* ad, std::size_t adLen,
+        const ConstIov* in, std::size_t inCount,
+        const Iov* out, std::size_t outCount,
+        void* macOut)
+    {
+        return impl::ChaCha20Poly1305::seal(key, keyLen, nonce, nonceLen, ad, adLen, in, inCount, out, outCount, macOut);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305::open(
+        const void* key, std::size_t keyLen,
+        const void* nonce, std::size_t nonceLen,
+        const void* ad, std::size_t adLen,
+        const ConstIov* in, std::size_t inCount,
+        const Iov* out, std::size_t outCount,
+        const void* macIn)
+    {
+        return impl::ChaCha20Poly1305::open(key, keyLen, nonce, nonceLen, ad, adLen, in, inCount, out, outCount, macIn);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::sealBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count)
+    {
+        return impl::ChaCha20Poly1305::sealBatch(key, keyLen, packets, count);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t ChaCha20Poly1305::openBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count, std::uint64_t* valid)
+    {
+        return impl::ChaCha20Poly1305::openBatch(key, keyLen, packets, count, valid);
+    }
 }
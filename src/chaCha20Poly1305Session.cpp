@@ -0,0 +1,91 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/crypto/chaCha20Poly1305Session.hpp>
+#include "impl/chaCha20Poly1305Session.hpp"
+
+namespace dci::crypto
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::ChaCha20Poly1305Session()
+        : himpl::FaceLayout<ChaCha20Poly1305Session, impl::ChaCha20Poly1305Session>()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::ChaCha20Poly1305Session(const ChaCha20Poly1305Session& from)
+        : himpl::FaceLayout<ChaCha20Poly1305Session, impl::ChaCha20Poly1305Session>(from.impl())
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::ChaCha20Poly1305Session(ChaCha20Poly1305Session&& from)
+        : himpl::FaceLayout<ChaCha20Poly1305Session, impl::ChaCha20Poly1305Session>(std::move(from.impl()))
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session& ChaCha20Poly1305Session::operator=(const ChaCha20Poly1305Session& from)
+    {
+        impl() = from.impl();
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session& ChaCha20Poly1305Session::operator=(ChaCha20Poly1305Session&& from)
+    {
+        impl() = std::move(from.impl());
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::~ChaCha20Poly1305Session()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::setKey(const void* key, std::size_t len)
+    {
+        return impl().setKey(key, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::setNoncePrefix(const void* prefix, std::size_t len)
+    {
+        return impl().setNoncePrefix(prefix, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::setCounter(std::uint64_t counter)
+    {
+        return impl().setCounter(counter);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint64_t ChaCha20Poly1305Session::counter() const
+    {
+        return impl().counter();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Session::seal(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, void* macOut)
+    {
+        return impl().seal(ad, adLen, in, out, len, macOut);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Session::open(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, const void* macIn)
+    {
+        return impl().open(ad, adLen, in, out, len, macIn);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::clear()
+    {
+        return impl().clear();
+    }
+}
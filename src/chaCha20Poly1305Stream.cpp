@@ -0,0 +1,109 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/crypto/chaCha20Poly1305Stream.hpp>
+#include "impl/chaCha20Poly1305Stream.hpp"
+
+namespace dci::crypto
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::ChaCha20Poly1305Stream()
+        : himpl::FaceLayout<ChaCha20Poly1305Stream, impl::ChaCha20Poly1305Stream>()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::ChaCha20Poly1305Stream(const ChaCha20Poly1305Stream& from)
+        : himpl::FaceLayout<ChaCha20Poly1305Stream, impl::ChaCha20Poly1305Stream>(from.impl())
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::ChaCha20Poly1305Stream(ChaCha20Poly1305Stream&& from)
+        : himpl::FaceLayout<ChaCha20Poly1305Stream, impl::ChaCha20Poly1305Stream>(std::move(from.impl()))
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream& ChaCha20Poly1305Stream::operator=(const ChaCha20Poly1305Stream& from)
+    {
+        impl() = from.impl();
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream& ChaCha20Poly1305Stream::operator=(ChaCha20Poly1305Stream&& from)
+    {
+        impl() = std::move(from.impl());
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::~ChaCha20Poly1305Stream()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setKey(const void* key, std::size_t len)
+    {
+        return impl().setKey(key, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setAd(const void* ad, std::size_t len)
+    {
+        return impl().setAd(ad, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setChunkSize(std::size_t chunkSize)
+    {
+        return impl().setChunkSize(chunkSize);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setWorkers(std::size_t workers)
+    {
+        return impl().setWorkers(workers);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::start(const void* prefix, std::size_t len)
+    {
+        return impl().start(prefix, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Stream::seek(std::uint64_t chunk)
+    {
+        return impl().seek(chunk);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Stream::encipher(const void* in, std::size_t len, void* out, bool last)
+    {
+        return impl().encipher(in, len, out, last);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Stream::decipher(const void* in, std::size_t len, void* out, bool last)
+    {
+        return impl().decipher(in, len, out, last);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::clear()
+    {
+        return impl().clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint64_t ChaCha20Poly1305Stream::sealedSize(std::uint64_t len, std::size_t chunkSize)
+    {
+        return impl::ChaCha20Poly1305Stream::sealedSize(len, chunkSize);
+    }
+}
@@ -0,0 +1,266 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#include "dispatch.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <cpuid.h>
+#endif
+
+namespace dci::crypto::cpu
+{
+    namespace
+    {
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::uint32_t detect()
+        {
+            std::uint32_t res = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+            std::uint32_t eax, ebx, ecx, edx;
+
+            if(__get_cpuid_max(0, nullptr) < 1)
+            {
+                return res;
+            }
+
+            __cpuid(1, eax, ebx, ecx, edx);
+            res |= (edx & bit_SSE2)     ? sse2   : 0u;
+            res |= (ecx & bit_SSSE3)    ? ssse3  : 0u;
+            res |= (ecx & bit_SSE4_1)   ? sse41  : 0u;
+            res |= (ecx & bit_AES)      ? aesni  : 0u;
+            res |= (ecx & bit_PCLMUL)   ? pclmul : 0u;
+
+            // ymm/zmm registers are usable only if the os saves them
+            std::uint64_t xcr0 = 0;
+            if(ecx & bit_OSXSAVE)
+            {
+                std::uint32_t lo, hi;
+                asm volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+                xcr0 = (static_cast<std::uint64_t>(hi) << 32) | lo;
+            }
+            const bool osAvx = (xcr0 & 0x06) == 0x06;
+            const bool osAvx512 = osAvx && (xcr0 & 0xe0) == 0xe0;
+
+            if(__get_cpuid_max(0, nullptr) >= 7)
+            {
+                __cpuid_count(7, 0, eax, ebx, ecx, edx);
+                res |= (ebx & bit_BMI2)                     ? bmi2       : 0u;
+                res |= (ebx & bit_ADX)                      ? adx        : 0u;
+                res |= (ebx & bit_SHA)                      ? sha        : 0u;
+                res |= (osAvx && (ebx & bit_AVX2))          ? avx2       : 0u;
+                res |= (osAvx512 && (ebx & bit_AVX512F))    ? avx512f    : 0u;
+                res |= (osAvx512 && (ebx & bit_AVX512VL))   ? avx512vl   : 0u;
+                res |= (osAvx512 && (ebx & bit_AVX512IFMA)) ? avx512ifma : 0u;
+            }
+#endif
+
+            return res;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        Tier tierOf(std::uint32_t features)
+        {
+            if(features & avx512f)
+            {
+                return Tier::avx512;
+            }
+
+            if(features & avx2)
+            {
+                return Tier::avx2;
+            }
+
+            if((features & (sse2|ssse3)) == (sse2|ssse3))
+            {
+                return Tier::ssse3;
+            }
+
+            return Tier::generic;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        Tier fromEnvironment(Tier detected)
+        {
+            const char* env = std::getenv("DCI_CRYPTO_CPU_TIER");
+            if(!env)
+            {
+                return detected;
+            }
+
+            static const std::pair<const char*, Tier> names[] =
+            {
+                {"generic", Tier::generic},
+                {"ssse3",   Tier::ssse3},
+                {"avx2",    Tier::avx2},
+                {"avx512",  Tier::avx512},
+            };
+
+            for(const auto& [name, tier] : names)
+            {
+                if(!strcmp(env, name))
+                {
+                    return std::min(tier, detected);
+                }
+            }
+
+            return detected;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::uint32_t parseMask(std::string_view names)
+        {
+            static const std::pair<std::string_view, Feature> features[] =
+            {
+                {"sse2",        sse2},
+                {"ssse3",       ssse3},
+                {"sse41",       sse41},
+                {"avx2",        avx2},
+                {"bmi2",        bmi2},
+                {"adx",         adx},
+                {"avx512f",     avx512f},
+                {"avx512vl",    avx512vl},
+                {"avx512ifma",  avx512ifma},
+                {"sha",         sha},
+                {"aesni",       aesni},
+                {"pclmul",      pclmul},
+            };
+
+            std::uint32_t res = 0;
+            while(!names.empty())
+            {
+                const std::size_t comma = names.find(',');
+                const std::string_view name = names.substr(0, comma);
+
+                for(const auto& [featureName, feature] : features)
+                {
+                    if(name == featureName)
+                    {
+                        res |= feature;
+                    }
+                }
+
+                names = std::string_view::npos == comma ? std::string_view{} : names.substr(comma + 1);
+            }
+
+            return res;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::uint32_t maskFromEnvironment()
+        {
+            const char* env = std::getenv("DCI_CRYPTO_CPU_MASK");
+            return env ? parseMask(env) : 0;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        struct Binding
+        {
+            std::string_view   _primitive;
+            Binder::Bind       _bind;
+            std::string_view   _kernel;
+        };
+
+        struct State
+        {
+            std::uint32_t           _features = detect();
+            Tier                    _detected = tierOf(_features);
+            Tier                    _active = fromEnvironment(_detected);
+            std::uint32_t           _masked = maskFromEnvironment();
+            std::mutex              _mtx;
+            std::vector<Binding>    _bindings;
+        };
+
+        State& state()
+        {
+            static State instance;
+            return instance;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint32_t features()
+    {
+        const State& s = state();
+        return s._features & ~s._masked;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool use(Tier minTier, std::uint32_t required)
+    {
+        const State& s = state();
+        return s._active >= minTier && (s._features & ~s._masked & required) == required;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Binder::Binder(std::string_view primitive, Bind bind)
+    {
+        State& s = state();
+        std::lock_guard lock{s._mtx};
+        s._bindings.push_back(Binding{primitive, bind, bind()});
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Tier detectedTier()
+    {
+        return state()._detected;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Tier activeTier()
+    {
+        return state()._active;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void forceTier(Tier tier)
+    {
+        State& s = state();
+        std::lock_guard lock{s._mtx};
+
+        s._active = std::min(tier, s._detected);
+        for(Binding& b : s._bindings)
+        {
+            b._kernel = b._bind();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void maskFeatures(std::string_view names)
+    {
+        State& s = state();
+        std::lock_guard lock{s._mtx};
+
+        s._masked = parseMask(names);
+        for(Binding& b : s._bindings)
+        {
+            b._kernel = b._bind();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::vector<std::pair<std::string_view, std::string_view>> activeKernels()
+    {
+        State& s = state();
+        std::lock_guard lock{s._mtx};
+
+        std::vector<std::pair<std::string_view, std::string_view>> res;
+        res.reserve(s._bindings.size());
+        for(const Binding& b : s._bindings)
+        {
+            res.emplace_back(b._primitive, b._kernel);
+        }
+
+        return res;
+    }
+}
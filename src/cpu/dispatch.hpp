@@ -0,0 +1,45 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#pragma once
+
+#include <dci/crypto/cpu.hpp>
+#include <cstdint>
+#include <string_view>
+
+namespace dci::crypto::cpu
+{
+    enum Feature : std::uint32_t
+    {
+        sse2        = 1u << 0,
+        ssse3       = 1u << 1,
+        sse41       = 1u << 2,
+        avx2        = 1u << 3,
+        bmi2        = 1u << 4,
+        adx         = 1u << 5,
+        avx512f     = 1u << 6,
+        avx512vl    = 1u << 7,
+        avx512ifma  = 1u << 8,
+        sha         = 1u << 9,
+        aesni       = 1u << 10,
+        pclmul      = 1u << 11,
+    };
+
+    std::uint32_t features();
+
+    // kernel needing minTier and features may be bound
+    bool use(Tier minTier, std::uint32_t required);
+
+    // binds one primitive's kernels at load time and again on every forceTier
+    class Binder
+    {
+    public:
+        using Bind = std::string_view (*)();
+        Binder(std::string_view primitive, Bind bind);
+    };
+}
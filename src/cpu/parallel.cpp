@@ -0,0 +1,158 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace dci::crypto::cpu
+{
+    namespace
+    {
+        struct Batch
+        {
+            void (*_call)(const void* ctx, std::size_t w);
+            const void*                 _ctx;
+            std::size_t                 _tasks;
+            std::atomic<std::size_t>    _next {0};
+            std::size_t                 _done {0};  // under Pool::_mtx
+        };
+
+        class Pool
+        {
+        public:
+            Pool()
+            {
+                const std::size_t want = std::max(1u, std::thread::hardware_concurrency()) - 1;
+                for(std::size_t i(0); i<want; ++i)
+                {
+                    try
+                    {
+                        std::thread{[this]{ work(); }}.detach();
+                        _threads++;
+                    }
+                    catch(const std::system_error&)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            std::size_t concurrency() const
+            {
+                return _threads + 1;
+            }
+
+            void run(Batch& batch)
+            {
+                {
+                    std::lock_guard lock{_mtx};
+                    _queue.push_back(&batch);
+                }
+                _cv.notify_all();
+
+                while(take(batch))
+                {
+                }
+
+                std::unique_lock lock{_mtx};
+                _doneCv.wait(lock, [&]{ return batch._done == batch._tasks; });
+                _queue.erase(std::remove(_queue.begin(), _queue.end(), &batch), _queue.end());
+            }
+
+        private:
+            // runs one task of batch, false when none is left to claim
+            bool take(Batch& batch)
+            {
+                const std::size_t w = batch._next.fetch_add(1);
+                if(w >= batch._tasks)
+                {
+                    return false;
+                }
+
+                execute(batch, w);
+                return true;
+            }
+
+            void execute(Batch& batch, std::size_t w)
+            {
+                batch._call(batch._ctx, w);
+
+                bool last;
+                {
+                    std::lock_guard lock{_mtx};
+                    last = ++batch._done == batch._tasks;
+                }
+                if(last)
+                {
+                    _doneCv.notify_all();
+                }
+            }
+
+            void work()
+            {
+                for(;;)
+                {
+                    // claimed under the lock while the batch is queued, so it outlives the task
+                    Batch* batch = nullptr;
+                    std::size_t w = 0;
+                    {
+                        std::unique_lock lock{_mtx};
+                        _cv.wait(lock, [&]
+                        {
+                            for(Batch* b : _queue)
+                            {
+                                w = b->_next.fetch_add(1);
+                                if(w < b->_tasks)
+                                {
+                                    batch = b;
+                                    return true;
+                                }
+                            }
+                            return false;
+                        });
+                    }
+
+                    execute(*batch, w);
+                }
+            }
+
+        private:
+            std::size_t                 _threads {0};
+            std::mutex                  _mtx;
+            std::condition_variable     _cv;
+            std::condition_variable     _doneCv;
+            std::deque<Batch*>          _queue;
+        };
+
+        // leaked on purpose: detached workers keep waiting on it, and process exit never joins them
+        Pool& pool()
+        {
+            static Pool* p = new Pool;
+            return *p;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void runTasks(std::size_t tasks, void (*call)(const void* ctx, std::size_t w), const void* ctx)
+    {
+        Batch batch {call, ctx, tasks};
+        pool().run(batch);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t poolConcurrency()
+    {
+        return pool().concurrency();
+    }
+}
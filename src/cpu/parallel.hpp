@@ -0,0 +1,60 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#pragma once
+
+#include <cstddef>
+
+namespace dci::crypto::cpu
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // runs call(ctx, w) for every w in [0, tasks) on a process wide pool of worker threads, started
+    // lazily on first use; the calling thread takes tasks too and returns when all are done, so
+    // everything still completes if no worker could be started; call must not throw
+    void runTasks(std::size_t tasks, void (*call)(const void* ctx, std::size_t w), const void* ctx);
+
+    // worker threads of the pool plus the calling one
+    std::size_t poolConcurrency();
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // splits [0, count) into at most workers contiguous ranges and calls f(begin, end) for each,
+    // spread over the calling thread and the pool; workers == 0 means one per hardware thread
+    template <class F>
+    void parallel(std::size_t count, std::size_t workers, F&& f)
+    {
+        if(!workers)
+        {
+            workers = poolConcurrency();
+        }
+        workers = workers < count ? workers : count;
+
+        if(workers <= 1)
+        {
+            if(count)
+            {
+                f(std::size_t{0}, count);
+            }
+            return;
+        }
+
+        struct Ctx
+        {
+            F&          f;
+            std::size_t per;
+            std::size_t extra;
+        } ctx {f, count / workers, count % workers};
+
+        runTasks(workers, [](const void* vctx, std::size_t w)
+        {
+            const Ctx& ctx = *static_cast<const Ctx*>(vctx);
+            const std::size_t begin = w*ctx.per + (w < ctx.extra ? w : ctx.extra);
+            ctx.f(begin, begin + ctx.per + (w < ctx.extra ? 1 : 0));
+        }, &ctx);
+    }
+}
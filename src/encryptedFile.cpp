@@ -0,0 +1,72 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/crypto/encryptedFile.hpp>
+#include "impl/encryptedFile.hpp"
+
+namespace dci::crypto
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile::EncryptedFile()
+        : himpl::FaceLayout<EncryptedFile, impl::EncryptedFile>()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile::EncryptedFile(EncryptedFile&& from)
+        : himpl::FaceLayout<EncryptedFile, impl::EncryptedFile>(std::move(from.impl()))
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile& EncryptedFile::operator=(EncryptedFile&& from)
+    {
+        impl() = std::move(from.impl());
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile::~EncryptedFile()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::create(const char* path, const void* key, std::size_t keyLen, std::uint64_t size, std::size_t segmentSize)
+    {
+        return impl().create(path, key, keyLen, size, segmentSize);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::write(const void* data, std::size_t len)
+    {
+        return impl().write(data, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::open(const char* path, const void* key, std::size_t keyLen)
+    {
+        return impl().open(path, key, keyLen);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint64_t EncryptedFile::size() const
+    {
+        return impl().size();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::read(std::uint64_t offset, void* out, std::size_t len)
+    {
+        return impl().read(offset, out, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::close()
+    {
+        return impl().close();
+    }
+}
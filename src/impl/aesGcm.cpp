@@ -0,0 +1,591 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "aesGcm.hpp"
+#include <cstring>
+#include <dci/utils/dbg.hpp>
+#include "../cpu/dispatch.hpp"
+
+namespace dci::crypto::impl
+{
+    namespace
+    {
+        // enough blocks for the 8-way kernels, small enough to stay in l1
+        constexpr std::size_t stitchSpan = 4096;
+
+        // sp 800-38d: inc32 leaves 2^32-2 blocks between J0 and its wrap back to it
+        constexpr std::uint64_t maxTextLen = 16 * ((std::uint64_t{1} << 32) - 2);
+
+        constexpr std::uint8_t xtime(std::uint8_t a)
+        {
+            return static_cast<std::uint8_t>((a << 1) ^ ((a >> 7) * 0x1b));
+        }
+
+        constexpr std::uint8_t gfMul(std::uint8_t a, std::uint8_t b)
+        {
+            std::uint8_t res = 0;
+            for(; b; b >>= 1)
+            {
+                if(b & 1)
+                {
+                    res ^= a;
+                }
+                a = xtime(a);
+            }
+            return res;
+        }
+
+        constexpr std::array<std::uint8_t, 256> makeSbox()
+        {
+            std::array<std::uint8_t, 256> res {};
+            for(std::size_t x(0); x<256; ++x)
+            {
+                // multiplicative inverse as x^254, then the affine map
+                std::uint8_t inv = 1;
+                for(std::size_t i(0); i<254; ++i)
+                {
+                    inv = gfMul(inv, static_cast<std::uint8_t>(x));
+                }
+
+                std::uint8_t s = 0x63;
+                for(int r(0); r<5; ++r)
+                {
+                    s ^= static_cast<std::uint8_t>((inv << r) | (inv >> ((8 - r) & 7)));
+                }
+                res[x] = s;
+            }
+            return res;
+        }
+
+        // table lookups, not constant time against cache timing; the aes-ni kernels are
+        constexpr std::array<std::uint8_t, 256> sbox = makeSbox();
+
+        void aesGcm_expandKey_generic(std::uint8_t roundKeys[aesGcm::roundKeysSize], const std::uint8_t* key, std::size_t nk, std::size_t rounds)
+        {
+            memcpy(roundKeys, key, 4*nk);
+
+            std::uint8_t rcon = 1;
+            for(std::size_t i(nk); i<4*(rounds+1); ++i)
+            {
+                std::uint8_t t[4];
+                memcpy(t, roundKeys + 4*(i-1), 4);
+
+                if(i % nk == 0)
+                {
+                    const std::uint8_t t0 = t[0];
+                    t[0] = sbox[t[1]] ^ rcon;
+                    t[1] = sbox[t[2]];
+                    t[2] = sbox[t[3]];
+                    t[3] = sbox[t0];
+                    rcon = xtime(rcon);
+                }
+                else if(nk > 6 && i % nk == 4)
+                {
+                    for(std::uint8_t& b : t)
+                    {
+                        b = sbox[b];
+                    }
+                }
+
+                for(std::size_t j(0); j<4; ++j)
+                {
+                    roundKeys[4*i + j] = roundKeys[4*(i-nk) + j] ^ t[j];
+                }
+            }
+        }
+
+        void encryptBlock(const std::uint8_t roundKeys[aesGcm::roundKeysSize], std::size_t rounds, const std::uint8_t in[16], std::uint8_t out[16])
+        {
+            std::uint8_t s[16];
+            for(std::size_t i(0); i<16; ++i)
+            {
+                s[i] = in[i] ^ roundKeys[i];
+            }
+
+            for(std::size_t r(1); r<=rounds; ++r)
+            {
+                // sub bytes and shift rows, byte 4*c+row
+                std::uint8_t t[16];
+                for(std::size_t c(0); c<4; ++c)
+                {
+                    for(std::size_t row(0); row<4; ++row)
+                    {
+                        t[4*c + row] = sbox[s[4*((c + row) % 4) + row]];
+                    }
+                }
+
+                if(r != rounds)
+                {
+                    for(std::size_t c(0); c<4; ++c)
+                    {
+                        const std::uint8_t a0 = t[4*c+0], a1 = t[4*c+1], a2 = t[4*c+2], a3 = t[4*c+3];
+                        const std::uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+                        t[4*c+0] = a0 ^ all ^ xtime(a0 ^ a1);
+                        t[4*c+1] = a1 ^ all ^ xtime(a1 ^ a2);
+                        t[4*c+2] = a2 ^ all ^ xtime(a2 ^ a3);
+                        t[4*c+3] = a3 ^ all ^ xtime(a3 ^ a0);
+                    }
+                }
+
+                for(std::size_t i(0); i<16; ++i)
+                {
+                    s[i] = t[i] ^ roundKeys[16*r + i];
+                }
+            }
+
+            memcpy(out, s, 16);
+        }
+
+        void inc32(std::uint8_t counter[16])
+        {
+            for(std::size_t i(15); i>=12; --i)
+            {
+                if(++counter[i])
+                {
+                    break;
+                }
+            }
+        }
+
+        void aesGcm_ctr_generic(const std::uint8_t roundKeys[aesGcm::roundKeysSize], std::size_t rounds, std::uint8_t counter[16], const std::uint8_t* in, std::uint8_t* out, std::size_t blocks)
+        {
+            for(; blocks; --blocks)
+            {
+                std::uint8_t ks[16];
+                encryptBlock(roundKeys, rounds, counter, ks);
+                inc32(counter);
+
+                for(std::size_t i(0); i<16; ++i)
+                {
+                    out[i] = in ? in[i] ^ ks[i] : ks[i];
+                }
+
+                in = in ? in + 16 : nullptr;
+                out += 16;
+            }
+        }
+
+        std::uint64_t loadBe(const std::uint8_t* p)
+        {
+            std::uint64_t res = 0;
+            for(std::size_t i(0); i<8; ++i)
+            {
+                res = (res << 8) | p[i];
+            }
+            return res;
+        }
+
+        void storeBe(std::uint8_t* p, std::uint64_t v)
+        {
+            for(std::size_t i(0); i<8; ++i)
+            {
+                p[i] = static_cast<std::uint8_t>(v >> (56 - 8*i));
+            }
+        }
+
+        // x = x * y in gf(2^128) bit by bit, sp 800-38d algorithm 1 without branches
+        void mulGeneric(std::uint8_t x[16], const std::uint8_t y[16])
+        {
+            const std::uint64_t x0 = loadBe(x), x1 = loadBe(x + 8);
+            std::uint64_t v0 = loadBe(y), v1 = loadBe(y + 8);
+            std::uint64_t z0 = 0, z1 = 0;
+
+            for(std::size_t i(0); i<128; ++i)
+            {
+                const std::uint64_t bit = (i < 64 ? x0 >> (63 - i) : x1 >> (127 - i)) & 1;
+                z0 ^= v0 & (0 - bit);
+                z1 ^= v1 & (0 - bit);
+
+                const std::uint64_t lsb = v1 & 1;
+                v1 = (v1 >> 1) | (v0 << 63);
+                v0 = (v0 >> 1) ^ (0xe100000000000000ull & (0 - lsb));
+            }
+
+            storeBe(x, z0);
+            storeBe(x + 8, z1);
+        }
+
+        void aesGcm_powers_generic(std::uint8_t powers[aesGcm::powersSize])
+        {
+            for(std::size_t k(1); k<aesGcm::maxPower; ++k)
+            {
+                memcpy(powers + 16*k, powers + 16*(k-1), 16);
+                mulGeneric(powers + 16*k, powers);
+            }
+        }
+
+        void aesGcm_ghash_generic(std::uint8_t x[16], const std::uint8_t powers[aesGcm::powersSize], const std::uint8_t* m, std::size_t blocks)
+        {
+            for(; blocks; --blocks)
+            {
+                for(std::size_t i(0); i<16; ++i)
+                {
+                    x[i] ^= m[i];
+                }
+
+                mulGeneric(x, powers);
+                m += 16;
+            }
+        }
+
+        using ExpandKey = void (*)(std::uint8_t roundKeys[aesGcm::roundKeysSize], const std::uint8_t* key, std::size_t nk, std::size_t rounds);
+        using Ctr = void (*)(const std::uint8_t roundKeys[aesGcm::roundKeysSize], std::size_t rounds, std::uint8_t counter[16], const std::uint8_t* in, std::uint8_t* out, std::size_t blocks);
+        using Powers = void (*)(std::uint8_t powers[aesGcm::powersSize]);
+        using Ghash = void (*)(std::uint8_t x[16], const std::uint8_t powers[aesGcm::powersSize], const std::uint8_t* m, std::size_t blocks);
+
+        ExpandKey expandKeyImpl = &aesGcm_expandKey_generic;
+        Ctr ctrImpl = &aesGcm_ctr_generic;
+        Powers powersImpl = &aesGcm_powers_generic;
+        Ghash ghashImpl = &aesGcm_ghash_generic;
+
+        std::string_view bind()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if(cpu::use(cpu::Tier::ssse3, cpu::ssse3 | cpu::aesni | cpu::pclmul))
+            {
+                expandKeyImpl = &aesGcm::aesGcm_expandKey_aesni;
+                ctrImpl = &aesGcm::aesGcm_ctr8_aesni;
+                powersImpl = &aesGcm::aesGcm_powers_pclmul;
+                ghashImpl = &aesGcm::aesGcm_ghash8_pclmul;
+                return "aesni";
+            }
+#endif
+
+            expandKeyImpl = &aesGcm_expandKey_generic;
+            ctrImpl = &aesGcm_ctr_generic;
+            powersImpl = &aesGcm_powers_generic;
+            ghashImpl = &aesGcm_ghash_generic;
+            return "generic";
+        }
+
+        const cpu::Binder binder {"aesGcm", &bind};
+
+        // constant time
+        bool macsEqual(const void* a, const void* b)
+        {
+            const uint8_t* a1 = static_cast<const uint8_t*>(a);
+            const uint8_t* b1 = static_cast<const uint8_t*>(b);
+
+            uint8_t diff = 0;
+
+            for(size_t i(0); i<16; ++i)
+            {
+                diff |= a1[i] ^ b1[i];
+            }
+
+            return 0 == diff;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::AesGcm()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::AesGcm(const AesGcm& from) = default;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::AesGcm(AesGcm&& from)
+        : AesGcm{from}
+    {
+        from.clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm::~AesGcm()
+    {
+        clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm& AesGcm::operator=(const AesGcm& from) = default;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    AesGcm& AesGcm::operator=(AesGcm&& from)
+    {
+        *this = from;
+        from.clear();
+
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::setKey(const void* key, std::size_t len)
+    {
+        dbgAssert(len == 16 || len == 24 || len == 32);
+
+        _rounds = len/4 + 6;
+        expandKeyImpl(_roundKeys.data(), static_cast<const std::uint8_t*>(key), len/4, _rounds);
+
+        // H = E(0)
+        std::array<std::uint8_t, 16> zero {};
+        ctrImpl(_roundKeys.data(), _rounds, zero.data(), nullptr, _powers.data(), 1);
+        powersImpl(_powers.data());
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::setAd(const void* ad, std::size_t len)
+    {
+        const std::uint8_t* ad1 = static_cast<const std::uint8_t*>(ad);
+        _ad.assign(ad1, ad1 + len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::start(const void* nonce, std::size_t len)
+    {
+        dbgAssert(_rounds);
+
+        _x.fill(0);
+        _pendingSize = 0;
+        _ctextLen = 0;
+        _overrun = false;
+
+        if(len == 12)
+        {
+            memcpy(_counter.data(), nonce, 12);
+            _counter[12] = _counter[13] = _counter[14] = 0;
+            _counter[15] = 1;
+        }
+        else
+        {
+            // J0 = GHASH(nonce || 0 pad || 0^64 || [len]64)
+            hash(nonce, len);
+            hashPad();
+
+            std::array<std::uint8_t, 16> lens {};
+            storeBe(lens.data() + 8, std::uint64_t{len} * 8);
+            hash(lens.data(), lens.size());
+
+            _counter = _x;
+            _x.fill(0);
+        }
+
+        // E(J0) masks the tag, the payload starts from inc32(J0)
+        ctrImpl(_roundKeys.data(), _rounds, _counter.data(), nullptr, _tagMask.data(), 1);
+        _position = 16;
+
+        hash(_ad.data(), _ad.size());
+        _adLen = _ad.size();
+        _adOpen = true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::encipher(const void* in, void* out, std::size_t len)
+    {
+        if(!fits(len))
+        {
+            return false;
+        }
+
+        const std::uint8_t* in1 = static_cast<const std::uint8_t*>(in);
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        closeAd();
+
+        // span by span, so the ciphertext is still in l1 when ghash reads it
+        while(len)
+        {
+            const std::size_t span = std::min(len, stitchSpan);
+            crypt(in1, out1, span);
+            hash(out1, span);
+            _ctextLen += span;
+
+            in1 = in1 ? in1 + span : nullptr;
+            out1 += span;
+            len -= span;
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::encipherFinish(void* macOut)
+    {
+        finish(macOut);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::decipher(const void* in, void* out, std::size_t len)
+    {
+        if(!fits(len))
+        {
+            return false;
+        }
+
+        const std::uint8_t* in1 = static_cast<const std::uint8_t*>(in);
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        closeAd();
+
+        // span by span, so the ciphertext is loaded from memory once for both passes
+        while(len)
+        {
+            const std::size_t span = std::min(len, stitchSpan);
+            hash(in1, span);
+            crypt(in1, out1, span);
+            _ctextLen += span;
+
+            in1 += span;
+            out1 += span;
+            len -= span;
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::decipherFinish(const void* macIn)
+    {
+        const bool overrun = _overrun;
+
+        std::array<std::uint8_t, 16> mac;
+        finish(mac.data());
+
+        return macsEqual(macIn, mac.data()) && !overrun;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::clear()
+    {
+        _roundKeys.fill(0);
+        _rounds = 0;
+        _powers.fill(0);
+        _ad.clear();
+        _tagMask.fill(0);
+        _counter.fill(0);
+        _buffer.fill(0);
+        _position = 16;
+        _x.fill(0);
+        _pending.fill(0);
+        _pendingSize = 0;
+        _adLen = 0;
+        _ctextLen = 0;
+        _adOpen = false;
+        _overrun = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool AesGcm::fits(std::size_t len)
+    {
+        if(_overrun || len > maxTextLen - _ctextLen)
+        {
+            _overrun = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::crypt(const std::uint8_t* in, std::uint8_t* out, std::size_t len)
+    {
+        // rest of a partly used keystream block
+        for(; len && _position < 16; --len)
+        {
+            *out++ = (in ? *in++ : 0) ^ _buffer[_position++];
+        }
+
+        const std::size_t blocks = len / 16;
+        if(blocks)
+        {
+            ctrImpl(_roundKeys.data(), _rounds, _counter.data(), in, out, blocks);
+            in = in ? in + 16*blocks : nullptr;
+            out += 16*blocks;
+            len -= 16*blocks;
+        }
+
+        if(len)
+        {
+            ctrImpl(_roundKeys.data(), _rounds, _counter.data(), nullptr, _buffer.data(), 1);
+            for(_position = 0; _position < len; ++_position)
+            {
+                out[_position] = (in ? in[_position] : 0) ^ _buffer[_position];
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::hash(const void* data, std::size_t len)
+    {
+        const std::uint8_t* data1 = static_cast<const std::uint8_t*>(data);
+
+        if(_pendingSize)
+        {
+            const std::size_t size = std::min(len, 16 - _pendingSize);
+            memcpy(_pending.data() + _pendingSize, data1, size);
+            _pendingSize += size;
+            data1 += size;
+            len -= size;
+
+            if(_pendingSize < 16)
+            {
+                return;
+            }
+
+            ghashImpl(_x.data(), _powers.data(), _pending.data(), 1);
+            _pendingSize = 0;
+        }
+
+        if(len / 16)
+        {
+            ghashImpl(_x.data(), _powers.data(), data1, len / 16);
+            data1 += len / 16 * 16;
+            len %= 16;
+        }
+
+        if(len)
+        {
+            memcpy(_pending.data(), data1, len);
+            _pendingSize = len;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::hashPad()
+    {
+        if(_pendingSize)
+        {
+            memset(_pending.data() + _pendingSize, 0, 16 - _pendingSize);
+            ghashImpl(_x.data(), _powers.data(), _pending.data(), 1);
+            _pendingSize = 0;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::closeAd()
+    {
+        if(_adOpen)
+        {
+            hashPad();
+            _adOpen = false;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void AesGcm::finish(void* mac)
+    {
+        closeAd();
+        hashPad();
+
+        std::array<std::uint8_t, 16> lens;
+        storeBe(lens.data(), _adLen * 8);
+        storeBe(lens.data() + 8, _ctextLen * 8);
+        ghashImpl(_x.data(), _powers.data(), lens.data(), 1);
+
+        std::uint8_t* mac1 = static_cast<std::uint8_t*>(mac);
+        for(std::size_t i(0); i<16; ++i)
+        {
+            mac1[i] = _x[i] ^ _tagMask[i];
+        }
+
+        _x.fill(0);
+        _ctextLen = 0;
+        _overrun = false;
+        _position = 16;
+    }
+}
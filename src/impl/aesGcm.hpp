@@ -0,0 +1,75 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "aesGcm/kernels.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace dci::crypto::impl
+{
+    class AesGcm final
+    {
+    public:
+        AesGcm();
+        AesGcm(const AesGcm&);
+        AesGcm(AesGcm&&);
+        ~AesGcm();
+
+        AesGcm& operator=(const AesGcm&);
+        AesGcm& operator=(AesGcm&&);
+
+    public:
+        void setKey(const void* key, std::size_t len);
+        void setAd(const void* ad, std::size_t len);
+
+        void start(const void* nonce, std::size_t len);
+
+        bool encipher(const void* in, void* out, std::size_t len);
+        void encipherFinish(void* macOut);
+
+        bool decipher(const void* in, void* out, std::size_t len);
+        bool decipherFinish(const void* macIn);
+
+        void clear();
+
+    private:
+        bool fits(std::size_t len);
+        void crypt(const std::uint8_t* in, std::uint8_t* out, std::size_t len);
+        void hash(const void* data, std::size_t len);
+        void hashPad();
+        void closeAd();
+        void finish(void* mac);
+
+    private:
+        std::array<std::uint8_t, aesGcm::roundKeysSize> _roundKeys {};
+        std::size_t                                     _rounds = 0;
+        std::array<std::uint8_t, aesGcm::powersSize>    _powers {};
+
+        std::vector<std::uint8_t>                       _ad;
+
+        // E(J0) for the tag and the counter of the next keystream block
+        std::array<std::uint8_t, 16>                    _tagMask {};
+        std::array<std::uint8_t, 16>                    _counter {};
+
+        // keystream of a partly used block
+        std::array<std::uint8_t, 16>                    _buffer {};
+        std::size_t                                     _position = 16;
+
+        // ghash accumulator and a partial input block
+        std::array<std::uint8_t, 16>                    _x {};
+        std::array<std::uint8_t, 16>                    _pending {};
+        std::size_t                                     _pendingSize = 0;
+
+        std::uint64_t                                   _adLen = 0;
+        std::uint64_t                                   _ctextLen = 0;
+        bool                                            _adOpen = false;
+        bool                                            _overrun = false;
+    };
+}
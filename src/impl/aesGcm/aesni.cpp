@@ -0,0 +1,269 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <dci/utils/dbg.hpp>
+#include <immintrin.h>
+#include <cstring>
+
+#pragma GCC push_options
+#pragma GCC target("ssse3,aes,pclmul")
+
+namespace dci::crypto::impl::aesGcm
+{
+    namespace
+    {
+        inline __m128i load(const std::uint8_t* p)
+        {
+            return _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(p)));
+        }
+
+        inline void store(std::uint8_t* p, __m128i v)
+        {
+            _mm_storeu_si128(static_cast<__m128i*>(static_cast<void*>(p)), v);
+        }
+
+        // gcm blocks are big endian bit strings, reversed bytes put them in the order pclmul
+        // multiplies, the bit reflection is fixed up by the shift in reduce
+        inline __m128i reverse(__m128i v)
+        {
+            return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        }
+
+        // 256 bit carry-less product of a and b accumulated into lo, hi
+        inline void mulAdd(__m128i a, __m128i b, __m128i& lo, __m128i& hi)
+        {
+            const __m128i ll = _mm_clmulepi64_si128(a, b, 0x00);
+            const __m128i hh = _mm_clmulepi64_si128(a, b, 0x11);
+            const __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+
+            lo = _mm_xor_si128(lo, _mm_xor_si128(ll, _mm_slli_si128(mid, 8)));
+            hi = _mm_xor_si128(hi, _mm_xor_si128(hh, _mm_srli_si128(mid, 8)));
+        }
+
+        // hi:lo shifted left by one (the reflection) and reduced modulo x^128 + x^7 + x^2 + x + 1
+        inline __m128i reduce(__m128i lo, __m128i hi)
+        {
+            __m128i c0 = _mm_srli_epi32(lo, 31);
+            __m128i c1 = _mm_srli_epi32(hi, 31);
+            lo = _mm_slli_epi32(lo, 1);
+            hi = _mm_slli_epi32(hi, 1);
+
+            const __m128i c2 = _mm_srli_si128(c0, 12);
+            c1 = _mm_slli_si128(c1, 4);
+            c0 = _mm_slli_si128(c0, 4);
+            lo = _mm_or_si128(lo, c0);
+            hi = _mm_or_si128(_mm_or_si128(hi, c1), c2);
+
+            __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+            const __m128i b = _mm_srli_si128(a, 4);
+            a = _mm_slli_si128(a, 12);
+            lo = _mm_xor_si128(lo, a);
+
+            __m128i d = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+            d = _mm_xor_si128(d, b);
+            lo = _mm_xor_si128(lo, d);
+
+            return _mm_xor_si128(hi, lo);
+        }
+
+        inline __m128i mul(__m128i a, __m128i b)
+        {
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+            mulAdd(a, b, lo, hi);
+            return reduce(lo, hi);
+        }
+
+        // aeskeygenassist puts RotWord(SubWord(w)) ^ rcon in dword 1 and SubWord(w) in dword 0
+        // for w in dword 1, so the sbox never goes through memory
+        template <int rcon>
+        inline __m128i assist(std::uint32_t w)
+        {
+            return _mm_aeskeygenassist_si128(_mm_set_epi32(0, 0, static_cast<int>(w), 0), rcon);
+        }
+
+        inline std::uint32_t subWord(std::uint32_t w)
+        {
+            return static_cast<std::uint32_t>(_mm_cvtsi128_si32(assist<0>(w)));
+        }
+
+        // the rcon must be an immediate, its index follows the public round number only
+        inline std::uint32_t rotSubWord(std::uint32_t w, std::size_t round)
+        {
+            __m128i r;
+            switch(round)
+            {
+            case 0: r = assist<0x01>(w); break;
+            case 1: r = assist<0x02>(w); break;
+            case 2: r = assist<0x04>(w); break;
+            case 3: r = assist<0x08>(w); break;
+            case 4: r = assist<0x10>(w); break;
+            case 5: r = assist<0x20>(w); break;
+            case 6: r = assist<0x40>(w); break;
+            case 7: r = assist<0x80>(w); break;
+            case 8: r = assist<0x1b>(w); break;
+            default:
+                dbgAssert(round == 9);
+                r = assist<0x36>(w);
+                break;
+            }
+
+            return static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_shuffle_epi32(r, 0x55)));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void aesGcm_expandKey_aesni(std::uint8_t roundKeys[roundKeysSize], const std::uint8_t* key, std::size_t nk, std::size_t rounds)
+    {
+        dbgAssert(rounds <= maxRounds);
+
+        memcpy(roundKeys, key, 4*nk);
+
+        for(std::size_t i(nk); i<4*(rounds+1); ++i)
+        {
+            std::uint32_t t;
+            memcpy(&t, roundKeys + 4*(i-1), 4);
+
+            if(i % nk == 0)
+            {
+                t = rotSubWord(t, i/nk - 1);
+            }
+            else if(nk > 6 && i % nk == 4)
+            {
+                t = subWord(t);
+            }
+
+            std::uint32_t w;
+            memcpy(&w, roundKeys + 4*(i-nk), 4);
+            w ^= t;
+            memcpy(roundKeys + 4*i, &w, 4);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void aesGcm_ctr8_aesni(const std::uint8_t roundKeys[roundKeysSize], std::size_t rounds, std::uint8_t counter[16], const std::uint8_t* in, std::uint8_t* out, std::size_t blocks)
+    {
+        dbgAssert(rounds <= maxRounds);
+
+        __m128i keys[maxRounds+1];
+        for(std::size_t k(0); k<=rounds; ++k)
+        {
+            keys[k] = load(roundKeys + 16*k);
+        }
+
+        // the counter word as the low lane of the reversed block, so inc32 is a lane add
+        __m128i ctr = reverse(load(counter));
+        const __m128i one = _mm_set_epi32(0, 0, 0, 1);
+
+        for(; blocks >= 8; blocks -= 8)
+        {
+            __m128i b[8];
+            #pragma GCC unroll 8
+            for(std::size_t i(0); i<8; ++i)
+            {
+                b[i] = _mm_xor_si128(reverse(ctr), keys[0]);
+                ctr = _mm_add_epi32(ctr, one);
+            }
+
+            for(std::size_t k(1); k<rounds; ++k)
+            {
+                #pragma GCC unroll 8
+                for(std::size_t i(0); i<8; ++i)
+                {
+                    b[i] = _mm_aesenc_si128(b[i], keys[k]);
+                }
+            }
+
+            #pragma GCC unroll 8
+            for(std::size_t i(0); i<8; ++i)
+            {
+                b[i] = _mm_aesenclast_si128(b[i], keys[rounds]);
+                store(out + 16*i, in ? _mm_xor_si128(b[i], load(in + 16*i)) : b[i]);
+            }
+
+            in = in ? in + 16*8 : nullptr;
+            out += 16*8;
+        }
+
+        for(; blocks; --blocks)
+        {
+            __m128i b = _mm_xor_si128(reverse(ctr), keys[0]);
+            ctr = _mm_add_epi32(ctr, one);
+
+            for(std::size_t k(1); k<rounds; ++k)
+            {
+                b = _mm_aesenc_si128(b, keys[k]);
+            }
+
+            b = _mm_aesenclast_si128(b, keys[rounds]);
+            store(out, in ? _mm_xor_si128(b, load(in)) : b);
+
+            in = in ? in + 16 : nullptr;
+            out += 16;
+        }
+
+        store(counter, reverse(ctr));
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void aesGcm_powers_pclmul(std::uint8_t powers[powersSize])
+    {
+        const __m128i h = reverse(load(powers));
+
+        __m128i p = h;
+        for(std::size_t k(1); k<maxPower; ++k)
+        {
+            p = mul(p, h);
+            store(powers + 16*k, reverse(p));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void aesGcm_ghash8_pclmul(std::uint8_t x[16], const std::uint8_t powers[powersSize], const std::uint8_t* m, std::size_t blocks)
+    {
+        __m128i h[maxPower];
+        for(std::size_t k(0); k<maxPower; ++k)
+        {
+            h[k] = reverse(load(powers + 16*k));
+        }
+
+        __m128i acc = reverse(load(x));
+
+        // (acc ^ m0)*H^8 ^ m1*H^7 ^ ... ^ m7*H, one reduction for all eight products
+        for(; blocks >= 8; blocks -= 8)
+        {
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+
+            mulAdd(_mm_xor_si128(acc, reverse(load(m))), h[7], lo, hi);
+            #pragma GCC unroll 7
+            for(std::size_t i(1); i<8; ++i)
+            {
+                mulAdd(reverse(load(m + 16*i)), h[7-i], lo, hi);
+            }
+
+            acc = reduce(lo, hi);
+            m += 16*8;
+        }
+
+        for(; blocks; --blocks)
+        {
+            acc = mul(_mm_xor_si128(acc, reverse(load(m))), h[0]);
+            m += 16;
+        }
+
+        store(x, reverse(acc));
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
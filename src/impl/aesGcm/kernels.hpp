@@ -0,0 +1,35 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dci::crypto::impl::aesGcm
+{
+    // expanded key as in fips-197, round key k at bytes [16*k, 16*k+16)
+    constexpr std::size_t maxRounds = 14;
+    constexpr std::size_t roundKeysSize = 16*(maxRounds+1);
+
+    // hash key powers H, H^2, ... H^maxPower as gcm blocks (bit 0 is the msb of byte 0)
+    constexpr std::size_t maxPower = 8;
+    constexpr std::size_t powersSize = 16*maxPower;
+
+    // fips-197 key expansion for nk = 4, 6 or 8 key words, sbox by aeskeygenassist
+    void aesGcm_expandKey_aesni(std::uint8_t roundKeys[roundKeysSize], const std::uint8_t* key, std::size_t nk, std::size_t rounds);
+
+    // out = in ^ E(counter) block by block, bare keystream if in is null; counter steps by
+    // inc32 (big endian increment of its last 4 bytes)
+    void aesGcm_ctr8_aesni(const std::uint8_t roundKeys[roundKeysSize], std::size_t rounds, std::uint8_t counter[16], const std::uint8_t* in, std::uint8_t* out, std::size_t blocks);
+
+    // fills powers[1..maxPower) from powers[0] = H
+    void aesGcm_powers_pclmul(std::uint8_t powers[powersSize]);
+
+    // x = (x ^ m[i]) * H for each block, 8 blocks per reduction
+    void aesGcm_ghash8_pclmul(std::uint8_t x[16], const std::uint8_t powers[powersSize], const std::uint8_t* m, std::size_t blocks);
+}
@@ -9,6 +9,7 @@
 #include <dci/crypto/blake2s.hpp>
 #include <dci/utils/endian.hpp>
 #include <dci/utils/dbg.hpp>
+#include "../cpu/dispatch.hpp"
 
 namespace dci::crypto::impl
 {
@@ -64,6 +65,79 @@ namespace dci::crypto::impl
             G(v[ 3], v[ 4], v[ 9], v[14], M[iE], M[iF]);
         }
 
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void blake2s_compress_generic(uint32_t H[8], uint32_t T[2], const uint32_t F[2], const uint8_t* input, size_t blocks, uint64_t increment)
+        {
+            for(size_t b = 0; b != blocks; ++b)
+            {
+                T[0] += increment;
+                if(T[0] < increment)
+                {
+                    T[1]++;
+                }
+
+                uint32_t M[16];
+                if constexpr(std::endian::little == std::endian::native)
+                {
+                    memcpy(M, input, sizeof(M));
+                }
+                else
+                {
+                    const uint32_t* input32 = static_cast<const uint32_t*>(static_cast<const void*>(input));
+                    for(size_t i(0); i<16; ++i)
+                    {
+                        M[i] = dci::utils::endian::n2l(input32[i]);
+                    }
+                }
+
+                input += Blake2s::BLOCKBYTES;
+
+                uint32_t v[16];
+
+                for(size_t i = 0; i < 8; i++)
+                {
+                    v[i] = H[i];
+                }
+
+                for(size_t i = 0; i != 8; ++i)
+                {
+                    v[i + 8] = IV[i];
+                }
+
+                v[12] ^= T[0];
+                v[13] ^= T[1];
+                v[14] ^= F[0];
+                v[15] ^= F[1];
+
+                ROUND< 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15>(v, M);
+                ROUND<14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3>(v, M);
+                ROUND<11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4>(v, M);
+                ROUND< 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8>(v, M);
+                ROUND< 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13>(v, M);
+                ROUND< 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9>(v, M);
+                ROUND<12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11>(v, M);
+                ROUND<13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10>(v, M);
+                ROUND< 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5>(v, M);
+                ROUND<10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0>(v, M);
+
+                for(size_t i = 0; i < 8; i++)
+                {
+                    H[i] ^= v[i] ^ v[i + 8];
+                }
+            }
+        }
+
+        using Compress = void (*)(uint32_t H[8], uint32_t T[2], const uint32_t F[2], const uint8_t* input, size_t blocks, uint64_t increment);
+
+        Compress compressImpl = &blake2s_compress_generic;
+
+        std::string_view compressBind()
+        {
+            compressImpl = &blake2s_compress_generic;
+            return "generic";
+        }
+
+        const cpu::Binder compressBinder {"blake2s", &compressBind};
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -259,63 +333,7 @@ namespace dci::crypto::impl
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void Blake2s::compress(const uint8_t* input, size_t blocks, uint64_t increment)
     {
-        for(size_t b = 0; b != blocks; ++b)
-        {
-            _T[0] += increment;
-            if(_T[0] < increment)
-            {
-                _T[1]++;
-            }
-
-            uint32_t M[16];
-            if constexpr(std::endian::little == std::endian::native)
-            {
-                memcpy(M, input, sizeof(M));
-            }
-            else
-            {
-                const uint32_t* input32 = static_cast<const uint32_t*>(static_cast<const void*>(input));
-                for(size_t i(0); i<16; ++i)
-                {
-                    M[i] = dci::utils::endian::n2l(input32[i]);
-                }
-            }
-
-            input += BLOCKBYTES;
-
-            uint32_t v[16];
-
-            for(size_t i = 0; i < 8; i++)
-            {
-                v[i] = _H[i];
-            }
-
-            for(size_t i = 0; i != 8; ++i)
-            {
-                v[i + 8] = IV[i];
-            }
-
-            v[12] ^= _T[0];
-            v[13] ^= _T[1];
-            v[14] ^= _F[0];
-            v[15] ^= _F[1];
-
-            ROUND< 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15>(v, M);
-            ROUND<14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3>(v, M);
-            ROUND<11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4>(v, M);
-            ROUND< 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8>(v, M);
-            ROUND< 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13>(v, M);
-            ROUND< 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9>(v, M);
-            ROUND<12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11>(v, M);
-            ROUND<13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10>(v, M);
-            ROUND< 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5>(v, M);
-            ROUND<10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0>(v, M);
-
-            for(size_t i = 0; i < 8; i++)
-            {
-                _H[i] ^= v[i] ^ v[i + 8];
-            }
-        }
+        compressImpl(_H.data(), _T.data(), _F.data(), input, blocks, increment);
     }
 
 }
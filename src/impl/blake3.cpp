@@ -8,6 +8,7 @@
 #include "blake3.hpp"
 #include <dci/crypto/blake3.hpp>
 #include <dci/utils/dbg.hpp>
+#include "../cpu/dispatch.hpp"
 
 namespace
 {
@@ -334,8 +335,8 @@ namespace
         store_cv_words(out, cv);
     }
 
-    void blake3_hash_many(const uint8_t *const *inputs, size_t num_inputs,
-                          size_t blocks, const uint32_t key[8],
+    void blake3_hash_many_portable(const uint8_t *const *inputs, size_t num_inputs,
+                                   size_t blocks, const uint32_t key[8],
     uint64_t counter, bool increment_counter,
     uint8_t flags, uint8_t flags_start,
     uint8_t flags_end, uint8_t *out) {
@@ -351,6 +352,30 @@ namespace
         }
     }
 
+    struct blake3_kernel {
+        decltype(&blake3_hash_many_portable) hash_many;
+        size_t simd_degree;
+    };
+
+    blake3_kernel blake3_impl = {&blake3_hash_many_portable, 1};
+
+    std::string_view blake3_bind() {
+        blake3_impl = {&blake3_hash_many_portable, 1};
+        return "generic";
+    }
+
+    const dci::crypto::cpu::Binder blake3_binder{"blake3", &blake3_bind};
+
+    void blake3_hash_many(const uint8_t *const *inputs, size_t num_inputs,
+                          size_t blocks, const uint32_t key[8],
+    uint64_t counter, bool increment_counter,
+    uint8_t flags, uint8_t flags_start,
+    uint8_t flags_end, uint8_t *out) {
+        blake3_impl.hash_many(inputs, num_inputs, blocks, key, counter,
+                              increment_counter, flags, flags_start, flags_end,
+                              out);
+    }
+
     size_t compress_parents_parallel(const uint8_t *child_chaining_values,
                                      size_t num_chaining_values,
                                      const uint32_t key[8], uint8_t flags,
@@ -387,7 +412,7 @@ namespace
     }
 
     size_t blake3_simd_degree(void) {
-        return 1;
+        return blake3_impl.simd_degree;
     }
 
     size_t compress_chunks_parallel(const uint8_t *input, size_t input_len,
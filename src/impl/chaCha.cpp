@@ -6,6 +6,9 @@
    You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
 
 #include "chaCha.hpp"
+#include "chaCha/kernels.hpp"
+#include "../cpu/dispatch.hpp"
+#include "../cpu/parallel.hpp"
 #include <dci/utils/endian.hpp>
 #include <dci/utils/dbg.hpp>
 #include <cstring>
@@ -30,6 +33,7 @@ namespace dci::crypto::impl
             return static_cast<T>((input << ROT) | (input >> (8*sizeof(T) - ROT)));
         }
 
+        template <size_t ROUNDS>
         void hchacha(uint32_t output[8], const uint32_t input[16], size_t rounds)
         {
             dbgAssert(rounds % 2 == 0);
@@ -39,7 +43,8 @@ namespace dci::crypto::impl
                      x08 = input[ 8], x09 = input[ 9], x10 = input[10], x11 = input[11],
                      x12 = input[12], x13 = input[13], x14 = input[14], x15 = input[15];
 
-            for(size_t i = 0; i != rounds / 2; ++i)
+            #pragma GCC unroll 10
+            for(size_t i = 0; i != (ROUNDS ? ROUNDS : rounds) / 2; ++i)
             {
                 CHACHA_QUARTER_ROUND(x00, x04, x08, x12);
                 CHACHA_QUARTER_ROUND(x01, x05, x09, x13);
@@ -62,82 +67,338 @@ namespace dci::crypto::impl
             output[7] = x15;
         }
 
-        void chacha_x8(uint8_t output[64*8], uint32_t input[16], size_t rounds)
+        template <size_t ROUNDS>
+        void chacha_block_generic(uint8_t output[64], const uint8_t* in, const uint32_t input[16], size_t rounds)
         {
             dbgAssert(rounds % 2 == 0);
 
-            uint32_t* output4 = static_cast<uint32_t*>(static_cast<void*>(output));
+            uint32_t x00 = input[ 0], x01 = input[ 1], x02 = input[ 2], x03 = input[ 3],
+                     x04 = input[ 4], x05 = input[ 5], x06 = input[ 6], x07 = input[ 7],
+                     x08 = input[ 8], x09 = input[ 9], x10 = input[10], x11 = input[11],
+                     x12 = input[12], x13 = input[13], x14 = input[14], x15 = input[15];
 
-            // TODO interleave rounds
-            for(size_t i = 0; i != 8; ++i)
+            #pragma GCC unroll 10
+            for(size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
             {
-                uint32_t x00 = input[ 0], x01 = input[ 1], x02 = input[ 2], x03 = input[ 3],
-                         x04 = input[ 4], x05 = input[ 5], x06 = input[ 6], x07 = input[ 7],
-                         x08 = input[ 8], x09 = input[ 9], x10 = input[10], x11 = input[11],
-                         x12 = input[12], x13 = input[13], x14 = input[14], x15 = input[15];
+                CHACHA_QUARTER_ROUND(x00, x04, x08, x12);
+                CHACHA_QUARTER_ROUND(x01, x05, x09, x13);
+                CHACHA_QUARTER_ROUND(x02, x06, x10, x14);
+                CHACHA_QUARTER_ROUND(x03, x07, x11, x15);
 
-                for(size_t r = 0; r != rounds / 2; ++r)
+                CHACHA_QUARTER_ROUND(x00, x05, x10, x15);
+                CHACHA_QUARTER_ROUND(x01, x06, x11, x12);
+                CHACHA_QUARTER_ROUND(x02, x07, x08, x13);
+                CHACHA_QUARTER_ROUND(x03, x04, x09, x14);
+            }
+
+            const uint32_t block[16] =
+            {
+                x00 + input[ 0], x01 + input[ 1], x02 + input[ 2], x03 + input[ 3],
+                x04 + input[ 4], x05 + input[ 5], x06 + input[ 6], x07 + input[ 7],
+                x08 + input[ 8], x09 + input[ 9], x10 + input[10], x11 + input[11],
+                x12 + input[12], x13 + input[13], x14 + input[14], x15 + input[15],
+            };
+
+            for(size_t j = 0; j != 16; ++j)
+            {
+                uint32_t word = dci::utils::endian::n2l(block[j]);
+
+                if(in)
                 {
-                    CHACHA_QUARTER_ROUND(x00, x04, x08, x12);
-                    CHACHA_QUARTER_ROUND(x01, x05, x09, x13);
-                    CHACHA_QUARTER_ROUND(x02, x06, x10, x14);
-                    CHACHA_QUARTER_ROUND(x03, x07, x11, x15);
-
-                    CHACHA_QUARTER_ROUND(x00, x05, x10, x15);
-                    CHACHA_QUARTER_ROUND(x01, x06, x11, x12);
-                    CHACHA_QUARTER_ROUND(x02, x07, x08, x13);
-                    CHACHA_QUARTER_ROUND(x03, x04, x09, x14);
+                    uint32_t m;
+                    memcpy(&m, in + 4*j, 4);
+                    word ^= m;
                 }
 
-                x00 += input[0];
-                x01 += input[1];
-                x02 += input[2];
-                x03 += input[3];
-                x04 += input[4];
-                x05 += input[5];
-                x06 += input[6];
-                x07 += input[7];
-                x08 += input[8];
-                x09 += input[9];
-                x10 += input[10];
-                x11 += input[11];
-                x12 += input[12];
-                x13 += input[13];
-                x14 += input[14];
-                x15 += input[15];
-
-                output4[16*i +  0] = dci::utils::endian::n2l(x00);
-                output4[16*i +  1] = dci::utils::endian::n2l(x01);
-                output4[16*i +  2] = dci::utils::endian::n2l(x02);
-                output4[16*i +  3] = dci::utils::endian::n2l(x03);
-                output4[16*i +  4] = dci::utils::endian::n2l(x04);
-                output4[16*i +  5] = dci::utils::endian::n2l(x05);
-                output4[16*i +  6] = dci::utils::endian::n2l(x06);
-                output4[16*i +  7] = dci::utils::endian::n2l(x07);
-                output4[16*i +  8] = dci::utils::endian::n2l(x08);
-                output4[16*i +  9] = dci::utils::endian::n2l(x09);
-                output4[16*i + 10] = dci::utils::endian::n2l(x10);
-                output4[16*i + 11] = dci::utils::endian::n2l(x11);
-                output4[16*i + 12] = dci::utils::endian::n2l(x12);
-                output4[16*i + 13] = dci::utils::endian::n2l(x13);
-                output4[16*i + 14] = dci::utils::endian::n2l(x14);
-                output4[16*i + 15] = dci::utils::endian::n2l(x15);
+                memcpy(output + 4*j, &word, 4);
+            }
+        }
+
+        template <size_t ROUNDS>
+        void chacha_x8_generic(uint8_t* output, const uint8_t* in, uint32_t input[16], size_t rounds)
+        {
+            for(size_t i = 0; i != 8; ++i)
+            {
+                chacha_block_generic<ROUNDS>(output + 64*i, in ? in + 64*i : nullptr, input, rounds);
 
                 input[12]++;
                 input[13] += (input[12] == 0);
             }
         }
+
+        template <size_t ROUNDS>
+        void chacha_lanes1_generic(uint8_t output[64], const uint32_t states[16], size_t rounds)
+        {
+            chacha_block_generic<ROUNDS>(output, nullptr, states, rounds);
+        }
+
+        struct Keystream
+        {
+            void (*generate)(uint8_t* output, const uint8_t* in, uint32_t input[16], size_t rounds);
+            size_t blocks;
+
+            void (*generateLanes)(uint8_t* output, const uint32_t* states, size_t rounds);
+            size_t lanes;
+
+            void (*generateBlock)(uint8_t output[64], const uint8_t* in, const uint32_t input[16], size_t rounds);
+        };
+
+        // kernel sets specialized for 8, 12 and 20 rounds, the last one loops any other count at runtime
+        Keystream keystreamImpls[4]
+        {
+            {&chacha_x8_generic< 8>, 8, &chacha_lanes1_generic< 8>, 1, &chacha_block_generic< 8>},
+            {&chacha_x8_generic<12>, 8, &chacha_lanes1_generic<12>, 1, &chacha_block_generic<12>},
+            {&chacha_x8_generic<20>, 8, &chacha_lanes1_generic<20>, 1, &chacha_block_generic<20>},
+            {&chacha_x8_generic< 0>, 8, &chacha_lanes1_generic< 0>, 1, &chacha_block_generic< 0>},
+        };
+
+        size_t kernelFor(size_t rounds)
+        {
+            switch(rounds)
+            {
+            case  8: return 0;
+            case 12: return 1;
+            case 20: return 2;
+            default: break;
+            }
+
+            return 3;
+        }
+
+        template <size_t ROUNDS>
+        Keystream pickKeystream(std::string_view& name)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if(cpu::use(cpu::Tier::avx512, cpu::avx512f))
+            {
+                name = "avx512";
+                return {&chaCha::chacha_x16_avx512<ROUNDS>, 16, &chaCha::chacha_lanes16_avx512<ROUNDS>, 16, &chacha_block_generic<ROUNDS>};
+            }
+
+            if(cpu::use(cpu::Tier::avx2, cpu::avx2))
+            {
+                name = "avx2";
+                return {&chaCha::chacha_x8_avx2<ROUNDS>, 8, &chaCha::chacha_lanes8_avx2<ROUNDS>, 8, &chacha_block_generic<ROUNDS>};
+            }
+
+            if(cpu::use(cpu::Tier::ssse3, cpu::ssse3))
+            {
+                name = "ssse3";
+                return {&chaCha::chacha_x4_ssse3<ROUNDS>, 4, &chaCha::chacha_lanes4_ssse3<ROUNDS>, 4, &chacha_block_generic<ROUNDS>};
+            }
+#endif
+            name = "generic";
+            return {&chacha_x8_generic<ROUNDS>, 8, &chacha_lanes1_generic<ROUNDS>, 1, &chacha_block_generic<ROUNDS>};
+        }
+
+        std::string_view keystreamBind()
+        {
+            std::string_view name;
+            keystreamImpls[0] = pickKeystream< 8>(name);
+            keystreamImpls[1] = pickKeystream<12>(name);
+            keystreamImpls[2] = pickKeystream<20>(name);
+            keystreamImpls[3] = pickKeystream< 0>(name);
+            return name;
+        }
+
+        const cpu::Binder keystreamBinder {"chaCha", &keystreamBind};
+
+        // moves the 64-bit block counter in input[12..13] forward
+        void advance(uint32_t input[16], uint64_t blocks)
+        {
+            const uint64_t counter = ((uint64_t{input[13]} << 32) | input[12]) + blocks;
+            input[12] = static_cast<uint32_t>(counter);
+            input[13] = static_cast<uint32_t>(counter >> 32);
+        }
+
+        // fills output with keystream for at least need bytes: single blocks when only a few are
+        // needed, otherwise as many blocks as the bound kernel produces at once; returns the size
+        size_t keystream(size_t kernel, uint8_t output[64*16], size_t need, uint32_t input[16], size_t rounds)
+        {
+            static constexpr size_t maxSingleBlocks = 2;
+
+            const Keystream impl = keystreamImpls[kernel];
+
+            const size_t blocks = (need + 63) / 64;
+            if(blocks <= maxSingleBlocks && blocks < impl.blocks)
+            {
+                for(size_t i(0); i<blocks; ++i)
+                {
+                    impl.generateBlock(output + 64*i, nullptr, input, rounds);
+                    advance(input, 1);
+                }
+
+                return blocks * 64;
+            }
+
+            impl.generate(output, nullptr, input, rounds);
+            return impl.blocks * 64;
+        }
+
+        // out = in ^ keystream (or just keystream if in is null) for whole kernel strides, straight
+        // from in to out without staging, returns the number of bytes processed
+        size_t keystreamBulk(size_t kernel, uint8_t* out, const uint8_t* in, size_t len, uint32_t input[16], size_t rounds)
+        {
+            const Keystream impl = keystreamImpls[kernel];
+            const size_t stride = impl.blocks * 64;
+
+            size_t done = 0;
+            for(; len - done >= stride; done += stride)
+            {
+                impl.generate(out + done, in ? in + done : nullptr, input, rounds);
+            }
+
+            return done;
+        }
+
+        // out = in ^ ks, or ks itself if in is null
+        void apply(uint8_t* out, const uint8_t* in, const uint8_t* ks, size_t len)
+        {
+            if(in)
+            {
+                size_t i(0);
+                for(; i+8<=len; i+=8)
+                {
+                    uint64_t a, b;
+                    memcpy(&a, in+i, 8);
+                    memcpy(&b, ks+i, 8);
+                    a ^= b;
+                    memcpy(out+i, &a, 8);
+                }
+
+                for(; i<len; ++i)
+                {
+                    out[i] = in[i] ^ ks[i];
+                }
+            }
+            else
+            {
+                memcpy(out, ks, len);
+            }
+        }
+
+        void loadKey(uint32_t key[8], const void* data, size_t len)
+        {
+            memset(key, 0, 8*4);
+            memcpy(key, data, std::min(len, size_t{32}));
+            key[0] = dci::utils::endian::n2l(key[0]);
+            key[1] = dci::utils::endian::n2l(key[1]);
+            key[2] = dci::utils::endian::n2l(key[2]);
+            key[3] = dci::utils::endian::n2l(key[3]);
+        }
+
+        void setup(uint32_t state[16], const uint32_t key[8], size_t keySize, const void* iv, size_t len, size_t rounds)
+        {
+            static const uint32_t TAU[] =
+            { 0x61707865, 0x3120646e, 0x79622d36, 0x6b206574 };
+
+            static const uint32_t SIGMA[] =
+            { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+
+            state[4] = key[0];
+            state[5] = key[1];
+            state[6] = key[2];
+            state[7] = key[3];
+
+            if(keySize == 4)
+            {
+                state[0] = TAU[0];
+                state[1] = TAU[1];
+                state[2] = TAU[2];
+                state[3] = TAU[3];
+
+                state[8] = key[0];
+                state[9] = key[1];
+                state[10] = key[2];
+                state[11] = key[3];
+            }
+            else
+            {
+                state[0] = SIGMA[0];
+                state[1] = SIGMA[1];
+                state[2] = SIGMA[2];
+                state[3] = SIGMA[3];
+
+                state[8] = key[4];
+                state[9] = key[5];
+                state[10] = key[6];
+                state[11] = key[7];
+            }
+
+            state[12] = 0;
+            state[13] = 0;
+            state[14] = 0;
+            state[15] = 0;
+
+            /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+            const uint32_t* iv4 = static_cast<const uint32_t*>(iv);
+            if(len == 0)
+            {
+                // Treat zero length IV same as an all-zero IV
+                state[14] = 0;
+                state[15] = 0;
+            }
+            else if(len == 8)
+            {
+                state[14] = dci::utils::endian::n2l(iv4[0]);
+                state[15] = dci::utils::endian::n2l(iv4[1]);
+            }
+            else if(len == 12)
+            {
+                state[13] = dci::utils::endian::n2l(iv4[0]);
+                state[14] = dci::utils::endian::n2l(iv4[1]);
+                state[15] = dci::utils::endian::n2l(iv4[2]);
+            }
+            else if(len == 24)
+            {
+                state[12] = dci::utils::endian::n2l(iv4[0]);
+                state[13] = dci::utils::endian::n2l(iv4[1]);
+                state[14] = dci::utils::endian::n2l(iv4[2]);
+                state[15] = dci::utils::endian::n2l(iv4[3]);
+
+                std::array<uint32_t, 8> hc {};
+                switch(rounds)
+                {
+                case  8: hchacha< 8>(hc.data(), state, rounds); break;
+                case 12: hchacha<12>(hc.data(), state, rounds); break;
+                case 20: hchacha<20>(hc.data(), state, rounds); break;
+                default: hchacha< 0>(hc.data(), state, rounds); break;
+                }
+
+                state[ 4] = hc[0];
+                state[ 5] = hc[1];
+                state[ 6] = hc[2];
+                state[ 7] = hc[3];
+                state[ 8] = hc[4];
+                state[ 9] = hc[5];
+                state[10] = hc[6];
+                state[11] = hc[7];
+                state[12] = 0;
+                state[13] = 0;
+                state[14] = dci::utils::endian::n2l(iv4[4]);
+                state[15] = dci::utils::endian::n2l(iv4[5]);
+            }
+            else
+            {
+                dbgWarn("bad iv len provided");
+            }
+        }
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     ChaCha::ChaCha(std::size_t rounds)
         : StreamCipher{}
         , _rounds{rounds}
+        , _kernel{kernelFor(rounds)}
         , _key{std::array<uint32_t, 8>{}}
         , _keySize{0}
         , _state{std::array<uint32_t, 16>{}}
-        , _buffer{std::array<uint8_t, 8*64>{}}
+        , _buffer{std::array<uint8_t, 16*64>{}}
+        , _bufferSize{0}
         , _position{0}
+        , _subkeyPrefix{std::array<uint8_t, 16>{}}
+        , _subkey{std::array<uint32_t, 8>{}}
+        , _subkeyValid{false}
     {
     }
 
@@ -145,11 +406,16 @@ namespace dci::crypto::impl
     ChaCha::ChaCha(const ChaCha& from)
         : StreamCipher{from}
         , _rounds{from._rounds}
+        , _kernel{from._kernel}
         , _key{from._key}
         , _keySize{from._keySize}
         , _state{from._state}
         , _buffer{from._buffer}
+        , _bufferSize{from._bufferSize}
         , _position{from._position}
+        , _subkeyPrefix{from._subkeyPrefix}
+        , _subkey{from._subkey}
+        , _subkeyValid{from._subkeyValid}
     {
     }
 
@@ -157,11 +423,16 @@ namespace dci::crypto::impl
     ChaCha::ChaCha(ChaCha&& from)
         : StreamCipher{std::move(from)}
         , _rounds{from._rounds}
+        , _kernel{from._kernel}
         , _key{from._key}
         , _keySize{from._keySize}
         , _state{from._state}
         , _buffer{from._buffer}
+        , _bufferSize{from._bufferSize}
         , _position{from._position}
+        , _subkeyPrefix{from._subkeyPrefix}
+        , _subkey{from._subkey}
+        , _subkeyValid{from._subkeyValid}
     {
         from.clear();
     }
@@ -177,11 +448,16 @@ namespace dci::crypto::impl
         static_cast<StreamCipher&>(*this) = from;
 
         _rounds = from._rounds;
+        _kernel = from._kernel;
         _key = from._key;
         _keySize = from._keySize;
         _state = from._state;
         _buffer = from._buffer;
+        _bufferSize = from._bufferSize;
         _position = from._position;
+        _subkeyPrefix = from._subkeyPrefix;
+        _subkey = from._subkey;
+        _subkeyValid = from._subkeyValid;
 
         return *this;
     }
@@ -192,11 +468,16 @@ namespace dci::crypto::impl
         static_cast<StreamCipher&>(*this) = from;
 
         _rounds = from._rounds;
+        _kernel = from._kernel;
         _key = from._key;
         _keySize = from._keySize;
         _state = from._state;
         _buffer = from._buffer;
+        _bufferSize = from._bufferSize;
         _position = from._position;
+        _subkeyPrefix = from._subkeyPrefix;
+        _subkey = from._subkey;
+        _subkeyValid = from._subkeyValid;
 
         from.clear();
 
@@ -207,12 +488,8 @@ namespace dci::crypto::impl
     void ChaCha::setKey(const void* key, std::size_t len)
     {
         _keySize = len/4;
-        _key = std::array<uint32_t, 8>{};
-        memcpy(_key.data(), key, std::min(len, std::size_t{32}));
-        _key[0] = dci::utils::endian::n2l(_key[0]);
-        _key[1] = dci::utils::endian::n2l(_key[1]);
-        _key[2] = dci::utils::endian::n2l(_key[2]);
-        _key[3] = dci::utils::endian::n2l(_key[3]);
+        loadKey(_key.data(), key, len);
+        _subkeyValid = false;
 
         setIv(nullptr, 0);
     }
@@ -220,149 +497,233 @@ namespace dci::crypto::impl
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void ChaCha::setIv(const void* iv, std::size_t len)
     {
-        static const uint32_t TAU[] =
-        { 0x61707865, 0x3120646e, 0x79622d36, 0x6b206574 };
-
-        static const uint32_t SIGMA[] =
-        { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+        if(len == 24 && _subkeyValid && !memcmp(_subkeyPrefix.data(), iv, 16))
+        {
+            // same key and nonce prefix, only the trailing 8 bytes differ - skip hchacha
+            setup(_state.data(), _key.data(), _keySize, nullptr, 0, _rounds);
 
-        _state[4] = _key[0];
-        _state[5] = _key[1];
-        _state[6] = _key[2];
-        _state[7] = _key[3];
+            for(size_t i(0); i<8; ++i)
+            {
+                _state[4+i] = _subkey[i];
+            }
 
-        if(_keySize == 4)
-        {
-            _state[0] = TAU[0];
-            _state[1] = TAU[1];
-            _state[2] = TAU[2];
-            _state[3] = TAU[3];
-
-            _state[8] = _key[0];
-            _state[9] = _key[1];
-            _state[10] = _key[2];
-            _state[11] = _key[3];
+            uint32_t tail[2];
+            memcpy(tail, static_cast<const uint8_t*>(iv) + 16, 8);
+            _state[14] = dci::utils::endian::n2l(tail[0]);
+            _state[15] = dci::utils::endian::n2l(tail[1]);
         }
         else
         {
-            _state[0] = SIGMA[0];
-            _state[1] = SIGMA[1];
-            _state[2] = SIGMA[2];
-            _state[3] = SIGMA[3];
-
-            _state[8] = _key[4];
-            _state[9] = _key[5];
-            _state[10] = _key[6];
-            _state[11] = _key[7];
-        }
+            setup(_state.data(), _key.data(), _keySize, iv, len, _rounds);
 
-        _state[12] = 0;
-        _state[13] = 0;
-        _state[14] = 0;
-        _state[15] = 0;
+            if(len == 24)
+            {
+                memcpy(_subkeyPrefix.data(), iv, 16);
+                for(size_t i(0); i<8; ++i)
+                {
+                    _subkey[i] = _state[4+i];
+                }
+                _subkeyValid = true;
+            }
+        }
 
+        // keystream is generated by the first cipher call
+        _bufferSize = 0;
         _position = 0;
+    }
 
-
-        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-        const uint32_t* iv4 = static_cast<const uint32_t*>(iv);
-        if(len == 0)
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha::cipher(const void* in, void* out, std::size_t len)
+    {
+        if(!len)
         {
-            // Treat zero length IV same as an all-zero IV
-            _state[14] = 0;
-            _state[15] = 0;
+            return;
         }
-        else if(len == 8)
+
+        const uint8_t* in1 = static_cast<const uint8_t*>(in);
+        uint8_t* out1 = static_cast<uint8_t*>(out);
+
+        if(!_bufferSize && (_position || len < keystreamImpls[_kernel].blocks * 64))
         {
-            _state[14] = dci::utils::endian::n2l(iv4[0]);
-            _state[15] = dci::utils::endian::n2l(iv4[1]);
+            // nothing generated since setIv/seek, _position is the offset into the block at the counter;
+            // at a block boundary with whole strides ahead the bulk path below starts right away
+            _bufferSize = keystream(_kernel, _buffer.data(), _position + len, _state.data(), _rounds);
         }
-        else if(len == 12)
+
+        const size_t available = _bufferSize - _position;
+        if(len < available)
         {
-            _state[13] = dci::utils::endian::n2l(iv4[0]);
-            _state[14] = dci::utils::endian::n2l(iv4[1]);
-            _state[15] = dci::utils::endian::n2l(iv4[2]);
+            apply(out1, in1, _buffer.data()+_position, len);
+            _position += len;
+            return;
         }
-        else if(len == 24)
+
+        // drain the buffered tail
+        apply(out1, in1, _buffer.data()+_position, available);
+        len -= available;
+        in1 = in1 ? in1 + available : nullptr;
+        out1 += available;
+
+        // whole strides bypass the buffer
+        const size_t bulk = keystreamBulk(_kernel, out1, in1, len, _state.data(), _rounds);
+        len -= bulk;
+        in1 = in1 ? in1 + bulk : nullptr;
+        out1 += bulk;
+
+        // the rest is shorter than a stride
+        if(len)
         {
-            _state[12] = dci::utils::endian::n2l(iv4[0]);
-            _state[13] = dci::utils::endian::n2l(iv4[1]);
-            _state[14] = dci::utils::endian::n2l(iv4[2]);
-            _state[15] = dci::utils::endian::n2l(iv4[3]);
-
-            std::array<uint32_t, 8> hc {};
-            hchacha(hc.data(), _state.data(), _rounds);
-
-            _state[ 4] = hc[0];
-            _state[ 5] = hc[1];
-            _state[ 6] = hc[2];
-            _state[ 7] = hc[3];
-            _state[ 8] = hc[4];
-            _state[ 9] = hc[5];
-            _state[10] = hc[6];
-            _state[11] = hc[7];
-            _state[12] = 0;
-            _state[13] = 0;
-            _state[14] = dci::utils::endian::n2l(iv4[4]);
-            _state[15] = dci::utils::endian::n2l(iv4[5]);
+            _bufferSize = keystream(_kernel, _buffer.data(), len, _state.data(), _rounds);
+            apply(out1, in1, _buffer.data(), len);
+            _position = len;
         }
         else
         {
-            dbgWarn("bad iv len provided");
+            _bufferSize = 0;
+            _position = 0;
         }
-
-        chacha_x8(_buffer.data(), _state.data(), _rounds);
-        _position = 0;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void ChaCha::cipher(const void* in, void* out, std::size_t len)
+    void ChaCha::cipherParallel(const void* in, void* out, std::size_t len, std::size_t workers)
     {
+        // unit of work split, a multiple of every kernel stride
+        static constexpr size_t groupSize = 16*64;
+
+        // smaller pieces are not worth a thread
+        static constexpr size_t minGroupsPerWorker = 64;
+
+        const uint8_t* in1 = static_cast<const uint8_t*>(in);
         uint8_t* out1 = static_cast<uint8_t*>(out);
 
-        if(in)
+        if(!_bufferSize && _position)
         {
-            const uint8_t* in1 = static_cast<const uint8_t*>(in);
-            while(len >= _buffer.size() - _position)
-            {
-                const size_t available = _buffer.size() - _position;
+            // lazily sought into the middle of a block
+            _bufferSize = keystream(_kernel, _buffer.data(), _position, _state.data(), _rounds);
+        }
+
+        // reach a block boundary through the buffered tail
+        const size_t available = std::min(len, _bufferSize - _position);
+        apply(out1, in1, _buffer.data()+_position, available);
+        _position += available;
+        len -= available;
+        in1 = in1 ? in1 + available : nullptr;
+        out1 += available;
+
+        // whole groups, each worker at its own counter offset
+        const size_t groups = len / groupSize;
+
+        if(!workers)
+        {
+            workers = cpu::poolConcurrency();
+        }
+        workers = std::max(size_t{1}, std::min(workers, groups / minGroupsPerWorker));
 
-                for(size_t i(0); i<available; ++i)
+        const std::array<uint32_t, 16> state = _state;
+        cpu::parallel(groups, workers, [&](size_t begin, size_t end)
+        {
+            std::array<uint32_t, 16> local = state;
+            advance(local.data(), begin * groupSize / 64);
+
+            keystreamBulk(
+                _kernel,
+                out1 + begin * groupSize,
+                in1 ? in1 + begin * groupSize : nullptr,
+                (end - begin) * groupSize,
+                local.data(),
+                _rounds);
+        });
+
+        advance(_state.data(), groups * groupSize / 64);
+        len -= groups * groupSize;
+        in1 = in1 ? in1 + groups * groupSize : nullptr;
+        out1 += groups * groupSize;
+
+        // the rest serially, the buffer is drained so the stream continues at _state
+        cipher(in1, out1, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha::cipherBatch(const ChaChaJob* jobs, std::size_t count, std::size_t rounds)
+    {
+        static constexpr size_t maxLanes = 16;
+
+        struct Lane
+        {
+            const uint8_t*  _in;
+            uint8_t*        _out;
+            size_t          _left;
+        };
+
+        const Keystream impl = keystreamImpls[kernelFor(rounds)];
+        dbgAssert(impl.lanes <= maxLanes);
+
+        std::array<uint32_t, 16*maxLanes> states {};
+        std::array<uint8_t, 64*maxLanes> blocks;
+        std::array<Lane, maxLanes> lanes {};
+
+        size_t next = 0;
+        auto feed = [&](size_t lane)
+        {
+            while(next < count)
+            {
+                const ChaChaJob& job = jobs[next++];
+                if(!job.len)
                 {
-                    out1[i] = in1[i] ^ _buffer[_position+i];
+                    continue;
                 }
 
-                chacha_x8(_buffer.data(), _state.data(), _rounds);
+                uint32_t* state = states.data() + 16*lane;
+                std::array<uint32_t, 8> key;
+                loadKey(key.data(), job.key, job.keyLen);
+                setup(state, key.data(), job.keyLen/4, job.iv, job.ivLen, rounds);
+                advance(state, job.counter);
 
-                len -= available;
-                in1 += available;
-                out1 += available;
-                _position = 0;
+                lanes[lane] = Lane{static_cast<const uint8_t*>(job.in), static_cast<uint8_t*>(job.out), job.len};
+                return true;
             }
 
-            for(size_t i(0); i<len; ++i)
-            {
-                out1[i] = in1[i] ^ _buffer[_position+i];
-            }
+            return false;
+        };
+
+        size_t active = 0;
+        for(size_t lane(0); lane<impl.lanes; ++lane)
+        {
+            active += feed(lane) ? 1 : 0;
         }
-        else
+
+        // one block per lane per step, a finished lane takes the next job
+        while(active)
         {
-            while(len >= _buffer.size() - _position)
+            impl.generateLanes(blocks.data(), states.data(), rounds);
+
+            for(size_t lane(0); lane<impl.lanes; ++lane)
             {
-                const size_t available = _buffer.size() - _position;
-                memcpy(out1, _buffer.data()+_position, available);
+                Lane& l = lanes[lane];
+                if(!l._left)
+                {
+                    continue;
+                }
 
-                chacha_x8(_buffer.data(), _state.data(), _rounds);
+                const size_t size = std::min(l._left, size_t{64});
+                apply(l._out, l._in, blocks.data() + 64*lane, size);
+                l._in = l._in ? l._in + size : nullptr;
+                l._out += size;
+                l._left -= size;
+                advance(states.data() + 16*lane, 1);
 
-                len -= available;
-                out1 += available;
-                _position = 0;
+                if(!l._left && !feed(lane))
+                {
+                    active--;
+                }
             }
-
-            memcpy(out1, _buffer.data()+_position, len);
         }
+    }
 
-        _position += len;
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t ChaCha::lanes(std::size_t rounds)
+    {
+        return keystreamImpls[kernelFor(rounds)].lanes;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -381,7 +742,8 @@ namespace dci::crypto::impl
         _state[12] = dci::utils::endian::n2l(out.by4[0]);
         _state[13] += dci::utils::endian::n2l(out.by4[1]);
 
-        chacha_x8(_buffer.data(), _state.data(), _rounds);
+        // keystream is generated by the next cipher call
+        _bufferSize = 0;
         _position = offset % 64;
     }
 
@@ -391,7 +753,11 @@ namespace dci::crypto::impl
         _key = std::array<uint32_t, 8>{};
         _keySize = 0;
         _state = std::array<uint32_t, 16>{};
-        _buffer = std::array<uint8_t, 8*64>{};
+        _buffer = std::array<uint8_t, 16*64>{};
+        _bufferSize = 0;
         _position = 0;
+        _subkeyPrefix = std::array<uint8_t, 16>{};
+        _subkey = std::array<uint32_t, 8>{};
+        _subkeyValid = false;
     }
 }
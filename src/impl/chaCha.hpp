@@ -8,6 +8,7 @@
 #pragma once
 
 #include "streamCipher.hpp"
+#include <dci/crypto/chaChaJob.hpp>
 #include <array>
 
 namespace dci::crypto::impl
@@ -28,16 +29,25 @@ namespace dci::crypto::impl
         void setKey(const void* key, std::size_t len) override;
         void setIv(const void* iv, std::size_t len) override;
         void cipher(const void* in, void* out, std::size_t len) override;
+        void cipherParallel(const void* in, void* out, std::size_t len, std::size_t workers);
+        static void cipherBatch(const ChaChaJob* jobs, std::size_t count, std::size_t rounds);
+        static std::size_t lanes(std::size_t rounds);
         void seek(std::uint64_t offset) override;
         void clear() override;
 
     private:
         std::size_t                 _rounds;
+        std::size_t                 _kernel;
         std::array<uint32_t, 8>     _key;
         std::size_t                 _keySize = 0;
         std::array<uint32_t, 16>    _state;
-        std::array<uint8_t, 8*64>   _buffer;
+        std::array<uint8_t, 16*64>  _buffer;
+        std::size_t                 _bufferSize = 0;
         std::size_t                 _position = 0;
 
+        // hchacha result for the last 16-byte prefix of a 24-byte iv under the current key
+        std::array<uint8_t, 16>     _subkeyPrefix;
+        std::array<uint32_t, 8>     _subkey;
+        bool                        _subkeyValid = false;
     };
 }
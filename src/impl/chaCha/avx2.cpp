@@ -0,0 +1,221 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <dci/utils/dbg.hpp>
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace dci::crypto::impl::chaCha
+{
+    namespace
+    {
+        inline __m256i rotl16(__m256i v)
+        {
+            const __m256i mask = _mm256_set_epi8(
+                        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+            return _mm256_shuffle_epi8(v, mask);
+        }
+
+        inline __m256i rotl8(__m256i v)
+        {
+            const __m256i mask = _mm256_set_epi8(
+                        14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                        14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+            return _mm256_shuffle_epi8(v, mask);
+        }
+
+        template <int ROT>
+        inline __m256i rotl(__m256i v)
+        {
+            return _mm256_or_si256(_mm256_slli_epi32(v, ROT), _mm256_srli_epi32(v, 32-ROT));
+        }
+
+        inline void quarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+        {
+            a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = rotl16(d);
+            c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = rotl<12>(b);
+            a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = rotl8(d);
+            c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = rotl<7>(b);
+        }
+
+        // output = v, or in ^ v when in is provided
+        inline void store(std::uint8_t* output, const std::uint8_t* in, std::size_t offset, __m256i v)
+        {
+            if(in)
+            {
+                v = _mm256_xor_si256(v, _mm256_loadu_si256(static_cast<const __m256i*>(static_cast<const void*>(in + offset))));
+            }
+
+            _mm256_storeu_si256(static_cast<__m256i*>(static_cast<void*>(output + offset)), v);
+        }
+
+        // x[k] holds word k of all 8 blocks, stores words 0..7 of each block
+        inline void transposeStore(std::uint8_t* output, const std::uint8_t* in, std::size_t offset, __m256i x0, __m256i x1, __m256i x2, __m256i x3, __m256i x4, __m256i x5, __m256i x6, __m256i x7)
+        {
+            const __m256i t0 = _mm256_unpacklo_epi32(x0, x1);
+            const __m256i t1 = _mm256_unpackhi_epi32(x0, x1);
+            const __m256i t2 = _mm256_unpacklo_epi32(x2, x3);
+            const __m256i t3 = _mm256_unpackhi_epi32(x2, x3);
+            const __m256i t4 = _mm256_unpacklo_epi32(x4, x5);
+            const __m256i t5 = _mm256_unpackhi_epi32(x4, x5);
+            const __m256i t6 = _mm256_unpacklo_epi32(x6, x7);
+            const __m256i t7 = _mm256_unpackhi_epi32(x6, x7);
+
+            const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+            const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+            const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+            const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+            const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+            const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+            const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+            const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+            store(output, in, offset + 0*64, _mm256_permute2x128_si256(u0, u4, 0x20));
+            store(output, in, offset + 1*64, _mm256_permute2x128_si256(u1, u5, 0x20));
+            store(output, in, offset + 2*64, _mm256_permute2x128_si256(u2, u6, 0x20));
+            store(output, in, offset + 3*64, _mm256_permute2x128_si256(u3, u7, 0x20));
+            store(output, in, offset + 4*64, _mm256_permute2x128_si256(u0, u4, 0x31));
+            store(output, in, offset + 5*64, _mm256_permute2x128_si256(u1, u5, 0x31));
+            store(output, in, offset + 6*64, _mm256_permute2x128_si256(u2, u6, 0x31));
+            store(output, in, offset + 7*64, _mm256_permute2x128_si256(u3, u7, 0x31));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <std::size_t ROUNDS>
+    void chacha_x8_avx2(std::uint8_t* output, const std::uint8_t* in, std::uint32_t input[16], std::size_t rounds)
+    {
+        dbgAssert(rounds % 2 == 0);
+
+        // per-lane block counters with carry into the high word
+        const __m256i ctrLo = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(input[12])), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        const __m256i sign = _mm256_set1_epi32(static_cast<int>(0x80000000));
+        const __m256i carry = _mm256_cmpgt_epi32(
+                                  _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(input[12])), sign),
+                                  _mm256_xor_si256(ctrLo, sign));
+        const __m256i ctrHi = _mm256_sub_epi32(_mm256_set1_epi32(static_cast<int>(input[13])), carry);
+
+        const __m256i i00 = _mm256_set1_epi32(static_cast<int>(input[ 0]));
+        const __m256i i01 = _mm256_set1_epi32(static_cast<int>(input[ 1]));
+        const __m256i i02 = _mm256_set1_epi32(static_cast<int>(input[ 2]));
+        const __m256i i03 = _mm256_set1_epi32(static_cast<int>(input[ 3]));
+        const __m256i i04 = _mm256_set1_epi32(static_cast<int>(input[ 4]));
+        const __m256i i05 = _mm256_set1_epi32(static_cast<int>(input[ 5]));
+        const __m256i i06 = _mm256_set1_epi32(static_cast<int>(input[ 6]));
+        const __m256i i07 = _mm256_set1_epi32(static_cast<int>(input[ 7]));
+        const __m256i i08 = _mm256_set1_epi32(static_cast<int>(input[ 8]));
+        const __m256i i09 = _mm256_set1_epi32(static_cast<int>(input[ 9]));
+        const __m256i i10 = _mm256_set1_epi32(static_cast<int>(input[10]));
+        const __m256i i11 = _mm256_set1_epi32(static_cast<int>(input[11]));
+        const __m256i i14 = _mm256_set1_epi32(static_cast<int>(input[14]));
+        const __m256i i15 = _mm256_set1_epi32(static_cast<int>(input[15]));
+
+        __m256i x00 = i00, x01 = i01, x02 = i02, x03 = i03,
+                x04 = i04, x05 = i05, x06 = i06, x07 = i07,
+                x08 = i08, x09 = i09, x10 = i10, x11 = i11,
+                x12 = ctrLo, x13 = ctrHi, x14 = i14, x15 = i15;
+
+        #pragma GCC unroll 10
+        for(std::size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
+        {
+            quarterRound(x00, x04, x08, x12);
+            quarterRound(x01, x05, x09, x13);
+            quarterRound(x02, x06, x10, x14);
+            quarterRound(x03, x07, x11, x15);
+
+            quarterRound(x00, x05, x10, x15);
+            quarterRound(x01, x06, x11, x12);
+            quarterRound(x02, x07, x08, x13);
+            quarterRound(x03, x04, x09, x14);
+        }
+
+        x00 = _mm256_add_epi32(x00, i00);
+        x01 = _mm256_add_epi32(x01, i01);
+        x02 = _mm256_add_epi32(x02, i02);
+        x03 = _mm256_add_epi32(x03, i03);
+        x04 = _mm256_add_epi32(x04, i04);
+        x05 = _mm256_add_epi32(x05, i05);
+        x06 = _mm256_add_epi32(x06, i06);
+        x07 = _mm256_add_epi32(x07, i07);
+        x08 = _mm256_add_epi32(x08, i08);
+        x09 = _mm256_add_epi32(x09, i09);
+        x10 = _mm256_add_epi32(x10, i10);
+        x11 = _mm256_add_epi32(x11, i11);
+        x12 = _mm256_add_epi32(x12, ctrLo);
+        x13 = _mm256_add_epi32(x13, ctrHi);
+        x14 = _mm256_add_epi32(x14, i14);
+        x15 = _mm256_add_epi32(x15, i15);
+
+        transposeStore(output, in,  0, x00, x01, x02, x03, x04, x05, x06, x07);
+        transposeStore(output, in, 32, x08, x09, x10, x11, x12, x13, x14, x15);
+
+        input[12] += 8;
+        input[13] += (input[12] < 8);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <std::size_t ROUNDS>
+    void chacha_lanes8_avx2(std::uint8_t output[64*8], const std::uint32_t states[16*8], std::size_t rounds)
+    {
+        dbgAssert(rounds % 2 == 0);
+
+        // i[k] holds word k of all 8 states
+        const __m256i index = _mm256_set_epi32(7*16, 6*16, 5*16, 4*16, 3*16, 2*16, 1*16, 0*16);
+
+        __m256i i[16];
+        __m256i x[16];
+        for(std::size_t k(0); k<16; ++k)
+        {
+            i[k] = _mm256_i32gather_epi32(static_cast<const int*>(static_cast<const void*>(states + k)), index, 4);
+            x[k] = i[k];
+        }
+
+        #pragma GCC unroll 10
+        for(std::size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
+        {
+            quarterRound(x[0], x[4], x[ 8], x[12]);
+            quarterRound(x[1], x[5], x[ 9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[ 8], x[13]);
+            quarterRound(x[3], x[4], x[ 9], x[14]);
+        }
+
+        for(std::size_t k(0); k<16; ++k)
+        {
+            x[k] = _mm256_add_epi32(x[k], i[k]);
+        }
+
+        transposeStore(output, nullptr,  0, x[0], x[1], x[ 2], x[ 3], x[ 4], x[ 5], x[ 6], x[ 7]);
+        transposeStore(output, nullptr, 32, x[8], x[9], x[10], x[11], x[12], x[13], x[14], x[15]);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template void chacha_x8_avx2<0>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x8_avx2<8>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x8_avx2<12>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x8_avx2<20>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+
+    template void chacha_lanes8_avx2<0>(std::uint8_t[64*8], const std::uint32_t[16*8], std::size_t);
+    template void chacha_lanes8_avx2<8>(std::uint8_t[64*8], const std::uint32_t[16*8], std::size_t);
+    template void chacha_lanes8_avx2<12>(std::uint8_t[64*8], const std::uint32_t[16*8], std::size_t);
+    template void chacha_lanes8_avx2<20>(std::uint8_t[64*8], const std::uint32_t[16*8], std::size_t);
+}
+
+#pragma GCC pop_options
+
+#endif
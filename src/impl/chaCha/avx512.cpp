@@ -0,0 +1,189 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <dci/utils/dbg.hpp>
+// _mm512_undefined_* in avx512fintrin.h trips -Wmaybe-uninitialized false positives
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+namespace dci::crypto::impl::chaCha
+{
+    namespace
+    {
+        inline void quarterRound(__m512i& a, __m512i& b, __m512i& c, __m512i& d)
+        {
+            a = _mm512_add_epi32(a, b); d = _mm512_xor_si512(d, a); d = _mm512_rol_epi32(d, 16);
+            c = _mm512_add_epi32(c, d); b = _mm512_xor_si512(b, c); b = _mm512_rol_epi32(b, 12);
+            a = _mm512_add_epi32(a, b); d = _mm512_xor_si512(d, a); d = _mm512_rol_epi32(d, 8);
+            c = _mm512_add_epi32(c, d); b = _mm512_xor_si512(b, c); b = _mm512_rol_epi32(b, 7);
+        }
+
+        // x[k] holds word k of all 16 blocks; r[j], 128-bit lane L: these 4 words of block 4L+j
+        inline void transpose4(__m512i x0, __m512i x1, __m512i x2, __m512i x3, __m512i r[4])
+        {
+            const __m512i t0 = _mm512_unpacklo_epi32(x0, x1);
+            const __m512i t1 = _mm512_unpackhi_epi32(x0, x1);
+            const __m512i t2 = _mm512_unpacklo_epi32(x2, x3);
+            const __m512i t3 = _mm512_unpackhi_epi32(x2, x3);
+
+            r[0] = _mm512_unpacklo_epi64(t0, t2);
+            r[1] = _mm512_unpackhi_epi64(t0, t2);
+            r[2] = _mm512_unpacklo_epi64(t1, t3);
+            r[3] = _mm512_unpackhi_epi64(t1, t3);
+        }
+
+        // output = v, or in ^ v when in is provided
+        inline void store(std::uint8_t* output, const std::uint8_t* in, std::size_t offset, __m512i v)
+        {
+            if(in)
+            {
+                v = _mm512_xor_si512(v, _mm512_loadu_si512(in + offset));
+            }
+
+            _mm512_storeu_si512(output + offset, v);
+        }
+
+        // r[q][j], 128-bit lane L: words 4q..4q+3 of block 4L+j
+        inline void storeBlocks(std::uint8_t* output, const std::uint8_t* in, const __m512i r[4][4])
+        {
+            for(std::size_t j(0); j<4; ++j)
+            {
+                const __m512i a = _mm512_shuffle_i32x4(r[0][j], r[1][j], 0x44);
+                const __m512i b = _mm512_shuffle_i32x4(r[2][j], r[3][j], 0x44);
+                const __m512i c = _mm512_shuffle_i32x4(r[0][j], r[1][j], 0xee);
+                const __m512i d = _mm512_shuffle_i32x4(r[2][j], r[3][j], 0xee);
+
+                store(output, in, (0*4 + j)*64, _mm512_shuffle_i32x4(a, b, 0x88));
+                store(output, in, (1*4 + j)*64, _mm512_shuffle_i32x4(a, b, 0xdd));
+                store(output, in, (2*4 + j)*64, _mm512_shuffle_i32x4(c, d, 0x88));
+                store(output, in, (3*4 + j)*64, _mm512_shuffle_i32x4(c, d, 0xdd));
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <std::size_t ROUNDS>
+    void chacha_x16_avx512(std::uint8_t* output, const std::uint8_t* in, std::uint32_t input[16], std::size_t rounds)
+    {
+        dbgAssert(rounds % 2 == 0);
+
+        // per-lane block counters with carry into the high word
+        const __m512i base = _mm512_set1_epi32(static_cast<int>(input[12]));
+        const __m512i ctrLo = _mm512_add_epi32(base, _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+        const __mmask16 carry = _mm512_cmplt_epu32_mask(ctrLo, base);
+        const __m512i hi = _mm512_set1_epi32(static_cast<int>(input[13]));
+        const __m512i ctrHi = _mm512_mask_add_epi32(hi, carry, hi, _mm512_set1_epi32(1));
+
+        const __m512i i00 = _mm512_set1_epi32(static_cast<int>(input[ 0]));
+        const __m512i i01 = _mm512_set1_epi32(static_cast<int>(input[ 1]));
+        const __m512i i02 = _mm512_set1_epi32(static_cast<int>(input[ 2]));
+        const __m512i i03 = _mm512_set1_epi32(static_cast<int>(input[ 3]));
+        const __m512i i04 = _mm512_set1_epi32(static_cast<int>(input[ 4]));
+        const __m512i i05 = _mm512_set1_epi32(static_cast<int>(input[ 5]));
+        const __m512i i06 = _mm512_set1_epi32(static_cast<int>(input[ 6]));
+        const __m512i i07 = _mm512_set1_epi32(static_cast<int>(input[ 7]));
+        const __m512i i08 = _mm512_set1_epi32(static_cast<int>(input[ 8]));
+        const __m512i i09 = _mm512_set1_epi32(static_cast<int>(input[ 9]));
+        const __m512i i10 = _mm512_set1_epi32(static_cast<int>(input[10]));
+        const __m512i i11 = _mm512_set1_epi32(static_cast<int>(input[11]));
+        const __m512i i14 = _mm512_set1_epi32(static_cast<int>(input[14]));
+        const __m512i i15 = _mm512_set1_epi32(static_cast<int>(input[15]));
+
+        __m512i x00 = i00, x01 = i01, x02 = i02, x03 = i03,
+                x04 = i04, x05 = i05, x06 = i06, x07 = i07,
+                x08 = i08, x09 = i09, x10 = i10, x11 = i11,
+                x12 = ctrLo, x13 = ctrHi, x14 = i14, x15 = i15;
+
+        #pragma GCC unroll 10
+        for(std::size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
+        {
+            quarterRound(x00, x04, x08, x12);
+            quarterRound(x01, x05, x09, x13);
+            quarterRound(x02, x06, x10, x14);
+            quarterRound(x03, x07, x11, x15);
+
+            quarterRound(x00, x05, x10, x15);
+            quarterRound(x01, x06, x11, x12);
+            quarterRound(x02, x07, x08, x13);
+            quarterRound(x03, x04, x09, x14);
+        }
+
+        __m512i r[4][4];
+        transpose4(_mm512_add_epi32(x00, i00), _mm512_add_epi32(x01, i01), _mm512_add_epi32(x02, i02), _mm512_add_epi32(x03, i03), r[0]);
+        transpose4(_mm512_add_epi32(x04, i04), _mm512_add_epi32(x05, i05), _mm512_add_epi32(x06, i06), _mm512_add_epi32(x07, i07), r[1]);
+        transpose4(_mm512_add_epi32(x08, i08), _mm512_add_epi32(x09, i09), _mm512_add_epi32(x10, i10), _mm512_add_epi32(x11, i11), r[2]);
+        transpose4(_mm512_add_epi32(x12, ctrLo), _mm512_add_epi32(x13, ctrHi), _mm512_add_epi32(x14, i14), _mm512_add_epi32(x15, i15), r[3]);
+        storeBlocks(output, in, r);
+
+        input[12] += 16;
+        input[13] += (input[12] < 16);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <std::size_t ROUNDS>
+    void chacha_lanes16_avx512(std::uint8_t output[64*16], const std::uint32_t states[16*16], std::size_t rounds)
+    {
+        dbgAssert(rounds % 2 == 0);
+
+        // i[k] holds word k of all 16 states
+        const __m512i index = _mm512_set_epi32(15*16, 14*16, 13*16, 12*16, 11*16, 10*16, 9*16, 8*16, 7*16, 6*16, 5*16, 4*16, 3*16, 2*16, 1*16, 0*16);
+
+        __m512i i[16];
+        __m512i x[16];
+        for(std::size_t k(0); k<16; ++k)
+        {
+            i[k] = _mm512_i32gather_epi32(index, states + k, 4);
+            x[k] = i[k];
+        }
+
+        #pragma GCC unroll 10
+        for(std::size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
+        {
+            quarterRound(x[0], x[4], x[ 8], x[12]);
+            quarterRound(x[1], x[5], x[ 9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[ 8], x[13]);
+            quarterRound(x[3], x[4], x[ 9], x[14]);
+        }
+
+        __m512i r[4][4];
+        transpose4(_mm512_add_epi32(x[ 0], i[ 0]), _mm512_add_epi32(x[ 1], i[ 1]), _mm512_add_epi32(x[ 2], i[ 2]), _mm512_add_epi32(x[ 3], i[ 3]), r[0]);
+        transpose4(_mm512_add_epi32(x[ 4], i[ 4]), _mm512_add_epi32(x[ 5], i[ 5]), _mm512_add_epi32(x[ 6], i[ 6]), _mm512_add_epi32(x[ 7], i[ 7]), r[1]);
+        transpose4(_mm512_add_epi32(x[ 8], i[ 8]), _mm512_add_epi32(x[ 9], i[ 9]), _mm512_add_epi32(x[10], i[10]), _mm512_add_epi32(x[11], i[11]), r[2]);
+        transpose4(_mm512_add_epi32(x[12], i[12]), _mm512_add_epi32(x[13], i[13]), _mm512_add_epi32(x[14], i[14]), _mm512_add_epi32(x[15], i[15]), r[3]);
+        storeBlocks(output, nullptr, r);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template void chacha_x16_avx512<0>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x16_avx512<8>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x16_avx512<12>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x16_avx512<20>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+
+    template void chacha_lanes16_avx512<0>(std::uint8_t[64*16], const std::uint32_t[16*16], std::size_t);
+    template void chacha_lanes16_avx512<8>(std::uint8_t[64*16], const std::uint32_t[16*16], std::size_t);
+    template void chacha_lanes16_avx512<12>(std::uint8_t[64*16], const std::uint32_t[16*16], std::size_t);
+    template void chacha_lanes16_avx512<20>(std::uint8_t[64*16], const std::uint32_t[16*16], std::size_t);
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,34 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dci::crypto::impl::chaCha
+{
+    // each kernel writes its blocks of keystream to output, or in ^ keystream when in is not null,
+    // and advances the block counter in input[12..13]; ROUNDS is 8, 12 or 20 for a fixed round
+    // count or 0 to take it from rounds at runtime
+
+    // 4 blocks, one block per 32-bit lane of xmm registers
+    template <std::size_t ROUNDS> void chacha_x4_ssse3(std::uint8_t* output, const std::uint8_t* in, std::uint32_t input[16], std::size_t rounds);
+
+    // 8 blocks, one block per 32-bit lane of ymm registers
+    template <std::size_t ROUNDS> void chacha_x8_avx2(std::uint8_t* output, const std::uint8_t* in, std::uint32_t input[16], std::size_t rounds);
+
+    // 16 blocks, one block per 32-bit lane of zmm registers
+    template <std::size_t ROUNDS> void chacha_x16_avx512(std::uint8_t* output, const std::uint8_t* in, std::uint32_t input[16], std::size_t rounds);
+
+    // one block for each of N independent states (16 words each, laid out back to back),
+    // block of state j goes to output + 64*j, the states are not advanced
+    template <std::size_t ROUNDS> void chacha_lanes4_ssse3(std::uint8_t output[64*4], const std::uint32_t states[16*4], std::size_t rounds);
+    template <std::size_t ROUNDS> void chacha_lanes8_avx2(std::uint8_t output[64*8], const std::uint32_t states[16*8], std::size_t rounds);
+    template <std::size_t ROUNDS> void chacha_lanes16_avx512(std::uint8_t output[64*16], const std::uint32_t states[16*16], std::size_t rounds);
+}
@@ -0,0 +1,197 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <dci/utils/dbg.hpp>
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+
+namespace dci::crypto::impl::chaCha
+{
+    namespace
+    {
+        inline __m128i rotl16(__m128i v)
+        {
+            const __m128i mask = _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+            return _mm_shuffle_epi8(v, mask);
+        }
+
+        inline __m128i rotl8(__m128i v)
+        {
+            const __m128i mask = _mm_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+            return _mm_shuffle_epi8(v, mask);
+        }
+
+        template <int ROT>
+        inline __m128i rotl(__m128i v)
+        {
+            return _mm_or_si128(_mm_slli_epi32(v, ROT), _mm_srli_epi32(v, 32-ROT));
+        }
+
+        inline void quarterRound(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+        {
+            a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = rotl16(d);
+            c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = rotl<12>(b);
+            a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = rotl8(d);
+            c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = rotl<7>(b);
+        }
+
+        // output = v, or in ^ v when in is provided
+        inline void store(std::uint8_t* output, const std::uint8_t* in, std::size_t offset, __m128i v)
+        {
+            if(in)
+            {
+                v = _mm_xor_si128(v, _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(in + offset))));
+            }
+
+            _mm_storeu_si128(static_cast<__m128i*>(static_cast<void*>(output + offset)), v);
+        }
+
+        // x[k] holds word k of all 4 blocks, stores these 4 words of each block
+        inline void transposeStore(std::uint8_t* output, const std::uint8_t* in, std::size_t offset, __m128i x0, __m128i x1, __m128i x2, __m128i x3)
+        {
+            const __m128i t0 = _mm_unpacklo_epi32(x0, x1);
+            const __m128i t1 = _mm_unpackhi_epi32(x0, x1);
+            const __m128i t2 = _mm_unpacklo_epi32(x2, x3);
+            const __m128i t3 = _mm_unpackhi_epi32(x2, x3);
+
+            store(output, in, offset + 0*64, _mm_unpacklo_epi64(t0, t2));
+            store(output, in, offset + 1*64, _mm_unpackhi_epi64(t0, t2));
+            store(output, in, offset + 2*64, _mm_unpacklo_epi64(t1, t3));
+            store(output, in, offset + 3*64, _mm_unpackhi_epi64(t1, t3));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <std::size_t ROUNDS>
+    void chacha_x4_ssse3(std::uint8_t* output, const std::uint8_t* in, std::uint32_t input[16], std::size_t rounds)
+    {
+        dbgAssert(rounds % 2 == 0);
+
+        // per-lane block counters with carry into the high word
+        const __m128i ctrLo = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(input[12])), _mm_set_epi32(3, 2, 1, 0));
+        const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000));
+        const __m128i carry = _mm_cmpgt_epi32(
+                                  _mm_xor_si128(_mm_set1_epi32(static_cast<int>(input[12])), sign),
+                                  _mm_xor_si128(ctrLo, sign));
+        const __m128i ctrHi = _mm_sub_epi32(_mm_set1_epi32(static_cast<int>(input[13])), carry);
+
+        const __m128i i00 = _mm_set1_epi32(static_cast<int>(input[ 0]));
+        const __m128i i01 = _mm_set1_epi32(static_cast<int>(input[ 1]));
+        const __m128i i02 = _mm_set1_epi32(static_cast<int>(input[ 2]));
+        const __m128i i03 = _mm_set1_epi32(static_cast<int>(input[ 3]));
+        const __m128i i04 = _mm_set1_epi32(static_cast<int>(input[ 4]));
+        const __m128i i05 = _mm_set1_epi32(static_cast<int>(input[ 5]));
+        const __m128i i06 = _mm_set1_epi32(static_cast<int>(input[ 6]));
+        const __m128i i07 = _mm_set1_epi32(static_cast<int>(input[ 7]));
+        const __m128i i08 = _mm_set1_epi32(static_cast<int>(input[ 8]));
+        const __m128i i09 = _mm_set1_epi32(static_cast<int>(input[ 9]));
+        const __m128i i10 = _mm_set1_epi32(static_cast<int>(input[10]));
+        const __m128i i11 = _mm_set1_epi32(static_cast<int>(input[11]));
+        const __m128i i14 = _mm_set1_epi32(static_cast<int>(input[14]));
+        const __m128i i15 = _mm_set1_epi32(static_cast<int>(input[15]));
+
+        __m128i x00 = i00, x01 = i01, x02 = i02, x03 = i03,
+                x04 = i04, x05 = i05, x06 = i06, x07 = i07,
+                x08 = i08, x09 = i09, x10 = i10, x11 = i11,
+                x12 = ctrLo, x13 = ctrHi, x14 = i14, x15 = i15;
+
+        #pragma GCC unroll 10
+        for(std::size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
+        {
+            quarterRound(x00, x04, x08, x12);
+            quarterRound(x01, x05, x09, x13);
+            quarterRound(x02, x06, x10, x14);
+            quarterRound(x03, x07, x11, x15);
+
+            quarterRound(x00, x05, x10, x15);
+            quarterRound(x01, x06, x11, x12);
+            quarterRound(x02, x07, x08, x13);
+            quarterRound(x03, x04, x09, x14);
+        }
+
+        transposeStore(output, in,  0, _mm_add_epi32(x00, i00), _mm_add_epi32(x01, i01), _mm_add_epi32(x02, i02), _mm_add_epi32(x03, i03));
+        transposeStore(output, in, 16, _mm_add_epi32(x04, i04), _mm_add_epi32(x05, i05), _mm_add_epi32(x06, i06), _mm_add_epi32(x07, i07));
+        transposeStore(output, in, 32, _mm_add_epi32(x08, i08), _mm_add_epi32(x09, i09), _mm_add_epi32(x10, i10), _mm_add_epi32(x11, i11));
+        transposeStore(output, in, 48, _mm_add_epi32(x12, ctrLo), _mm_add_epi32(x13, ctrHi), _mm_add_epi32(x14, i14), _mm_add_epi32(x15, i15));
+
+        input[12] += 4;
+        input[13] += (input[12] < 4);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <std::size_t ROUNDS>
+    void chacha_lanes4_ssse3(std::uint8_t output[64*4], const std::uint32_t states[16*4], std::size_t rounds)
+    {
+        dbgAssert(rounds % 2 == 0);
+
+        // transpose 4x4 word tiles of the states, i[k] holds word k of all 4 states
+        __m128i i[16];
+        for(std::size_t q(0); q<4; ++q)
+        {
+            const __m128i r0 = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(states + 0*16 + 4*q)));
+            const __m128i r1 = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(states + 1*16 + 4*q)));
+            const __m128i r2 = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(states + 2*16 + 4*q)));
+            const __m128i r3 = _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(states + 3*16 + 4*q)));
+
+            const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+            const __m128i t1 = _mm_unpackhi_epi32(r0, r1);
+            const __m128i t2 = _mm_unpacklo_epi32(r2, r3);
+            const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+            i[4*q + 0] = _mm_unpacklo_epi64(t0, t2);
+            i[4*q + 1] = _mm_unpackhi_epi64(t0, t2);
+            i[4*q + 2] = _mm_unpacklo_epi64(t1, t3);
+            i[4*q + 3] = _mm_unpackhi_epi64(t1, t3);
+        }
+
+        __m128i x[16];
+        for(std::size_t k(0); k<16; ++k)
+        {
+            x[k] = i[k];
+        }
+
+        #pragma GCC unroll 10
+        for(std::size_t r = 0; r != (ROUNDS ? ROUNDS : rounds) / 2; ++r)
+        {
+            quarterRound(x[0], x[4], x[ 8], x[12]);
+            quarterRound(x[1], x[5], x[ 9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[ 8], x[13]);
+            quarterRound(x[3], x[4], x[ 9], x[14]);
+        }
+
+        transposeStore(output, nullptr,  0, _mm_add_epi32(x[ 0], i[ 0]), _mm_add_epi32(x[ 1], i[ 1]), _mm_add_epi32(x[ 2], i[ 2]), _mm_add_epi32(x[ 3], i[ 3]));
+        transposeStore(output, nullptr, 16, _mm_add_epi32(x[ 4], i[ 4]), _mm_add_epi32(x[ 5], i[ 5]), _mm_add_epi32(x[ 6], i[ 6]), _mm_add_epi32(x[ 7], i[ 7]));
+        transposeStore(output, nullptr, 32, _mm_add_epi32(x[ 8], i[ 8]), _mm_add_epi32(x[ 9], i[ 9]), _mm_add_epi32(x[10], i[10]), _mm_add_epi32(x[11], i[11]));
+        transposeStore(output, nullptr, 48, _mm_add_epi32(x[12], i[12]), _mm_add_epi32(x[13], i[13]), _mm_add_epi32(x[14], i[14]), _mm_add_epi32(x[15], i[15]));
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template void chacha_x4_ssse3<0>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x4_ssse3<8>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x4_ssse3<12>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+    template void chacha_x4_ssse3<20>(std::uint8_t*, const std::uint8_t*, std::uint32_t[16], std::size_t);
+
+    template void chacha_lanes4_ssse3<0>(std::uint8_t[64*4], const std::uint32_t[16*4], std::size_t);
+    template void chacha_lanes4_ssse3<8>(std::uint8_t[64*4], const std::uint32_t[16*4], std::size_t);
+    template void chacha_lanes4_ssse3<12>(std::uint8_t[64*4], const std::uint32_t[16*4], std::size_t);
+    template void chacha_lanes4_ssse3<20>(std::uint8_t[64*4], const std::uint32_t[16*4], std::size_t);
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -7,9 +7,247 @@
 
 #include "chaCha20Poly1305.hpp"
 #include <dci/utils/endian.hpp>
+#include <dci/utils/dbg.hpp>
 
 namespace dci::crypto::impl
 {
+    namespace
+    {
+        // enough blocks for the vector poly1305 kernels, small enough to stay in l1
+        constexpr std::size_t stitchSpan = 4096;
+
+        // calls f(in, out, len) for each overlapping run of the two scatter lists
+        template <class F>
+        void zip(const ConstIov* in, std::size_t inCount, const Iov* out, std::size_t outCount, F&& f)
+        {
+            std::size_t inPos = 0, outPos = 0;
+            while(inCount && outCount)
+            {
+                const std::size_t len = std::min(in->len - inPos, out->len - outPos);
+                if(len)
+                {
+                    f(static_cast<const std::uint8_t*>(in->data) + inPos, static_cast<std::uint8_t*>(out->data) + outPos, len);
+                }
+
+                inPos += len;
+                outPos += len;
+
+                if(inPos == in->len)
+                {
+                    ++in;
+                    --inCount;
+                    inPos = 0;
+                }
+
+                if(outPos == out->len)
+                {
+                    ++out;
+                    --outCount;
+                    outPos = 0;
+                }
+            }
+        }
+
+        bool cfrgNonce(std::size_t len)
+        {
+            return len==12 || len==24;
+        }
+
+        // constant time
+        bool macsEqual(const void* a, const void* b)
+        {
+            const uint8_t* a1 = static_cast<const uint8_t*>(a);
+            const uint8_t* b1 = static_cast<const uint8_t*>(b);
+
+            uint8_t diff = 0;
+
+            for(size_t i(0); i<16; ++i)
+            {
+                diff |= a1[i] ^ b1[i];
+            }
+
+            return 0 == diff;
+        }
+
+        // packets set up together by a batch call, bounds its stack use
+        constexpr std::size_t batchChunk = 64;
+
+        // mac input of a cfrg packet as runs of whole blocks: ad, padded ad tail, ciphertext,
+        // padded ciphertext tail together with the lengths block
+        class MacFeed
+        {
+        public:
+            MacFeed() = default;
+
+            MacFeed(const void* ad, std::size_t adLen, const void* text, std::size_t textLen)
+                : _ad{static_cast<const std::uint8_t*>(ad)}
+                , _adLen{adLen}
+                , _text{static_cast<const std::uint8_t*>(text)}
+                , _textLen{textLen}
+            {
+            }
+
+            // next run into m, 0 blocks once everything is given out
+            std::size_t next(const std::uint8_t*& m)
+            {
+                for(;;)
+                {
+                    switch(_stage++)
+                    {
+                    case 0:
+                        m = _ad;
+                        if(_adLen / 16)
+                        {
+                            return _adLen / 16;
+                        }
+                        break;
+
+                    case 1:
+                        if(_adLen % 16)
+                        {
+                            _tail.fill(0);
+                            memcpy(_tail.data(), _ad + _adLen - _adLen % 16, _adLen % 16);
+                            m = _tail.data();
+                            return 1;
+                        }
+                        break;
+
+                    case 2:
+                        m = _text;
+                        if(_textLen / 16)
+                        {
+                            return _textLen / 16;
+                        }
+                        break;
+
+                    case 3:
+                        {
+                            _tail.fill(0);
+
+                            const std::uint64_t lens[2] =
+                            {
+                                dci::utils::endian::n2l(static_cast<std::uint64_t>(_adLen)),
+                                dci::utils::endian::n2l(static_cast<std::uint64_t>(_textLen)),
+                            };
+                            memcpy(_tail.data() + 32, lens, 16);
+
+                            if(_textLen % 16)
+                            {
+                                memcpy(_tail.data() + 16, _text + _textLen - _textLen % 16, _textLen % 16);
+                                m = _tail.data() + 16;
+                                return 2;
+                            }
+
+                            m = _tail.data() + 32;
+                            return 1;
+                        }
+
+                    default:
+                        return 0;
+                    }
+                }
+            }
+
+        private:
+            const std::uint8_t*             _ad = nullptr;
+            std::size_t                     _adLen = 0;
+            const std::uint8_t*             _text = nullptr;
+            std::size_t                     _textLen = 0;
+            std::array<std::uint8_t, 48>    _tail {};
+            int                             _stage = 0;
+        };
+
+        // macs of the cfrg packets among packets[0..count) over text(packet), one packet per
+        // poly1305 lane, a lane takes the next packet when its message ends; keys holds 32 bytes
+        // of poly1305 key per packet, done(index, mac) gets each result
+        template <class Text, class Done>
+        void macBatch(const ChaCha20Poly1305Packet* packets, std::size_t count, const std::uint8_t* keys, Text&& text, Done&& done)
+        {
+            const std::size_t width = Poly1305::lanes();
+
+            std::array<Poly1305, Poly1305::maxLanes> macs;
+            std::array<MacFeed, Poly1305::maxLanes> feeds;
+            std::array<Poly1305*, Poly1305::maxLanes> lanes {};
+            std::array<const void*, Poly1305::maxLanes> data {};
+            std::array<const std::uint8_t*, Poly1305::maxLanes> at {};
+            std::array<std::size_t, Poly1305::maxLanes> left {};
+            std::array<std::size_t, Poly1305::maxLanes> packetOf {};
+
+            std::size_t next = 0;
+            auto feed = [&](std::size_t lane)
+            {
+                for(; next < count; ++next)
+                {
+                    const ChaCha20Poly1305Packet& p = packets[next];
+                    if(!cfrgNonce(p.nonceLen))
+                    {
+                        continue;
+                    }
+
+                    macs[lane].setKey(keys + 32*next, 32);
+                    feeds[lane] = MacFeed{p.ad, p.adLen, text(p), p.len};
+                    left[lane] = feeds[lane].next(at[lane]);
+                    lanes[lane] = &macs[lane];
+                    packetOf[lane] = next++;
+                    return true;
+                }
+
+                lanes[lane] = nullptr;
+                return false;
+            };
+
+            std::size_t active = 0;
+            for(std::size_t lane(0); lane<width; ++lane)
+            {
+                active += feed(lane) ? 1 : 0;
+            }
+
+            // all lanes step together up to the shortest run, then the ended runs move on
+            while(active)
+            {
+                std::size_t blocks = ~std::size_t{};
+                for(std::size_t lane(0); lane<width; ++lane)
+                {
+                    if(lanes[lane])
+                    {
+                        blocks = std::min(blocks, left[lane]);
+                        data[lane] = at[lane];
+                    }
+                }
+
+                Poly1305::addLanes(lanes.data(), data.data(), blocks);
+
+                for(std::size_t lane(0); lane<width; ++lane)
+                {
+                    if(!lanes[lane])
+                    {
+                        continue;
+                    }
+
+                    at[lane] += 16*blocks;
+                    left[lane] -= blocks;
+
+                    if(!left[lane])
+                    {
+                        left[lane] = feeds[lane].next(at[lane]);
+                    }
+
+                    if(!left[lane])
+                    {
+                        std::array<std::uint8_t, 16> mac;
+                        macs[lane].finish(mac.data());
+                        done(packetOf[lane], mac.data());
+
+                        if(!feed(lane))
+                        {
+                            active--;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     ChaCha20Poly1305::ChaCha20Poly1305()
         : _chaCha{20}
@@ -21,6 +259,8 @@ namespace dci::crypto::impl
         : _chaCha{from._chaCha}
         , _poly1305{from._poly1305}
         , _ad{from._ad}
+        , _adLen{from._adLen}
+        , _adOpen{from._adOpen}
         , _nonceLen{from._nonceLen}
         , _ctextLen{from._ctextLen}
     {
@@ -31,6 +271,8 @@ namespace dci::crypto::impl
         : _chaCha{std::move(from._chaCha)}
         , _poly1305{std::move(from._poly1305)}
         , _ad{std::move(from._ad)}
+        , _adLen{std::move(from._adLen)}
+        , _adOpen{std::move(from._adOpen)}
         , _nonceLen{std::move(from._nonceLen)}
         , _ctextLen{std::move(from._ctextLen)}
     {
@@ -50,6 +292,8 @@ namespace dci::crypto::impl
         _chaCha = from._chaCha;
         _poly1305 = from._poly1305;
         _ad = from._ad;
+        _adLen = from._adLen;
+        _adOpen = from._adOpen;
         _nonceLen = from._nonceLen;
         _ctextLen = from._ctextLen;
 
@@ -62,6 +306,8 @@ namespace dci::crypto::impl
         _chaCha = std::move(from._chaCha);
         _poly1305 = std::move(from._poly1305);
         _ad = std::move(from._ad);
+        _adLen = std::move(from._adLen);
+        _adOpen = std::move(from._adOpen);
         _nonceLen = std::move(from._nonceLen);
         _ctextLen = std::move(from._ctextLen);
 
@@ -85,8 +331,113 @@ namespace dci::crypto::impl
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void ChaCha20Poly1305::start(const void* nonce, std::size_t len)
+    {
+        start(nonce, len, _ad.data(), _ad.size());
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::sealBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count)
+    {
+        std::array<ChaChaJob, 2*batchChunk> jobs;
+        std::array<std::uint8_t, 32*batchChunk> keys;
+
+        while(count)
+        {
+            const std::size_t chunk = std::min(count, batchChunk);
+
+            // poly1305 keys from block 0 and the ciphertexts from block 1 on, all in one go
+            std::size_t jobCount = 0;
+            for(std::size_t i(0); i<chunk; ++i)
+            {
+                const ChaCha20Poly1305Packet& p = packets[i];
+                if(!cfrgNonce(p.nonceLen))
+                {
+                    const ConstIov in {p.in, p.len};
+                    const Iov out {p.out, p.len};
+                    seal(key, keyLen, p.nonce, p.nonceLen, p.ad, p.adLen, &in, 1, &out, 1, p.mac);
+                    continue;
+                }
+
+                jobs[jobCount++] = ChaChaJob{key, keyLen, p.nonce, p.nonceLen, 0, nullptr, keys.data() + 32*i, 32};
+                jobs[jobCount++] = ChaChaJob{key, keyLen, p.nonce, p.nonceLen, 1, p.in, p.out, p.len};
+            }
+
+            ChaCha::cipherBatch(jobs.data(), jobCount, 20);
+
+            macBatch(packets, chunk, keys.data(),
+                     [](const ChaCha20Poly1305Packet& p){ return p.out; },
+                     [&](std::size_t i, const std::uint8_t* mac){ memcpy(packets[i].mac, mac, 16); });
+
+            packets += chunk;
+            count -= chunk;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t ChaCha20Poly1305::openBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count, std::uint64_t* valid)
+    {
+        std::array<ChaChaJob, batchChunk> jobs;
+        std::array<std::uint8_t, 32*batchChunk> keys;
+
+        std::size_t opened = 0;
+
+        auto mark = [&](std::size_t index, bool ok)
+        {
+            const std::uint64_t bit = std::uint64_t{1} << (index % 64);
+            valid[index / 64] = ok ? (valid[index / 64] | bit) : (valid[index / 64] & ~bit);
+            opened += ok ? 1 : 0;
+        };
+
+        for(std::size_t base(0); base<count; base += batchChunk)
+        {
+            const ChaCha20Poly1305Packet* chunkPackets = packets + base;
+            const std::size_t chunk = std::min(count - base, batchChunk);
+
+            // poly1305 keys from block 0
+            std::size_t jobCount = 0;
+            for(std::size_t i(0); i<chunk; ++i)
+            {
+                const ChaCha20Poly1305Packet& p = chunkPackets[i];
+                if(!cfrgNonce(p.nonceLen))
+                {
+                    const ConstIov in {p.in, p.len};
+                    const Iov out {p.out, p.len};
+                    mark(base + i, open(key, keyLen, p.nonce, p.nonceLen, p.ad, p.adLen, &in, 1, &out, 1, p.mac));
+                    continue;
+                }
+
+                jobs[jobCount++] = ChaChaJob{key, keyLen, p.nonce, p.nonceLen, 0, nullptr, keys.data() + 32*i, 32};
+            }
+
+            ChaCha::cipherBatch(jobs.data(), jobCount, 20);
+
+            // macs over the ciphertexts, then plaintext from block 1 on only for the authentic ones
+            jobCount = 0;
+            macBatch(chunkPackets, chunk, keys.data(),
+                     [](const ChaCha20Poly1305Packet& p){ return p.in; },
+                     [&](std::size_t i, const std::uint8_t* mac)
+                     {
+                         const ChaCha20Poly1305Packet& p = chunkPackets[i];
+                         const bool ok = macsEqual(mac, p.mac);
+                         mark(base + i, ok);
+
+                         if(ok)
+                         {
+                             jobs[jobCount++] = ChaChaJob{key, keyLen, p.nonce, p.nonceLen, 1, p.in, p.out, p.len};
+                         }
+                     });
+
+            ChaCha::cipherBatch(jobs.data(), jobCount, 20);
+        }
+
+        return opened;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::start(const void* nonce, std::size_t len, const void* ad, std::size_t adLen)
     {
         _ctextLen = 0;
+        _adLen = adLen;
         _nonceLen = len;
 
         _chaCha.setIv(nonce, len);
@@ -97,103 +448,239 @@ namespace dci::crypto::impl
         _poly1305.setKey(firstBlock.data(), 32);
         // Remainder of first block is discarded
 
-        _poly1305.add(_ad.data(), _ad.size());
+        _poly1305.add(ad, adLen);
 
-        if(cfrgVersion())
+        // more may come through addAd until the first ciphertext
+        _adOpen = true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::start(const void* nonce, std::size_t len, const void* ad, std::size_t adLen, const void* polyKey)
+    {
+        _ctextLen = 0;
+        _adLen = adLen;
+        _nonceLen = len;
+
+        _chaCha.setIv(nonce, len);
+        _chaCha.seek(64);
+
+        _poly1305.setKey(polyKey, 32);
+        _poly1305.add(ad, adLen);
+
+        _adOpen = true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::addAd(const void* ad, std::size_t len)
+    {
+        dbgAssert(_adOpen);
+
+        _poly1305.add(ad, len);
+        _adLen += len;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::encipher(const void* in, void* out, std::size_t len)
+    {
+        const std::uint8_t* in1 = static_cast<const std::uint8_t*>(in);
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        closeAd();
+
+        // span by span, so the ciphertext is still in l1 when poly1305 reads it
+        while(len)
         {
-            if(_ad.size() % 16)
-            {
-                const uint8_t zeros[16] = { 0 };
-               _poly1305.add(zeros, 16 - _ad.size() % 16);
-            }
+            const std::size_t span = std::min(len, stitchSpan);
+            _chaCha.cipher(in1, out1, span);
+            _poly1305.add(out1, span); // poly1305 of ciphertext
+            _ctextLen += span;
+
+            in1 = in1 ? in1 + span : nullptr;
+            out1 += span;
+            len -= span;
         }
-        else
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::encipherFinish(void* macOut)
+    {
+        finish(macOut);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::decipher(const void* in, void* out, std::size_t len)
+    {
+        const std::uint8_t* in1 = static_cast<const std::uint8_t*>(in);
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        closeAd();
+
+        // span by span, so the ciphertext is loaded from memory once for both passes
+        while(len)
         {
-            updateLen(_ad.size());
+            const std::size_t span = std::min(len, stitchSpan);
+            _poly1305.add(in1, span); // poly1305 of ciphertext
+            _chaCha.cipher(in1, out1, span);
+            _ctextLen += span;
+
+            in1 += span;
+            out1 += span;
+            len -= span;
         }
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void ChaCha20Poly1305::encipher(const void* in, void* out, std::size_t len)
+    bool ChaCha20Poly1305::decipherFinish(const void* macIn)
     {
-        _chaCha.cipher(in, out, len);
-        _poly1305.add(out, len); // poly1305 of ciphertext
-        _ctextLen += len;
+        return verify(macIn);
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void ChaCha20Poly1305::encipherFinish(void* macOut)
+    bool ChaCha20Poly1305::decipherVerified(const void* in, void* out, std::size_t len, const void* macIn)
     {
-        if(cfrgVersion())
+        authenticate(in, len);
+
+        if(!verify(macIn))
         {
-            if(_ctextLen % 16)
-            {
-                const uint8_t zeros[16] = { 0 };
-                _poly1305.add(zeros, 16 - _ctextLen % 16);
-            }
-            updateLen(_ad.size());
+            return false;
         }
-        updateLen(_ctextLen);
 
-        _poly1305.finish(macOut);
-        _ctextLen = 0;
+        _chaCha.cipher(in, out, len);
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::clear()
+    {
+        _chaCha.clear();
+        _poly1305.clear();
+        _ad.clear();
+        _adLen = 0;
+        _adOpen = false;
         _nonceLen = 0;
+        _ctextLen = 0;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void ChaCha20Poly1305::decipher(const void* in, void* out, std::size_t len)
+    void ChaCha20Poly1305::seal(
+        const void* key, std::size_t keyLen,
+        const void* nonce, std::size_t nonceLen,
+        const void* ad, std::size_t adLen,
+        const ConstIov* in, std::size_t inCount,
+        const Iov* out, std::size_t outCount,
+        void* macOut)
     {
-        _poly1305.add(in, len); // poly1305 of ciphertext
-        _chaCha.cipher(in, out, len);
-        _ctextLen += len;
+        ChaCha20Poly1305 aead;
+        aead.setKey(key, keyLen);
+        aead.start(nonce, nonceLen, ad, adLen);
+
+        zip(in, inCount, out, outCount, [&](const std::uint8_t* in1, std::uint8_t* out1, std::size_t len)
+        {
+            aead.encipher(in1, out1, len);
+        });
+
+        aead.finish(macOut);
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    bool ChaCha20Poly1305::decipherFinish(const void* macIn)
+    bool ChaCha20Poly1305::open(
+        const void* key, std::size_t keyLen,
+        const void* nonce, std::size_t nonceLen,
+        const void* ad, std::size_t adLen,
+        const ConstIov* in, std::size_t inCount,
+        const Iov* out, std::size_t outCount,
+        const void* macIn)
     {
-        if(cfrgVersion())
+        ChaCha20Poly1305 aead;
+        aead.setKey(key, keyLen);
+        aead.start(nonce, nonceLen, ad, adLen);
+
+        // a forged message costs its mac only, no keystream
+        for(std::size_t i(0); i<inCount; ++i)
         {
-            if(_ctextLen % 16)
-            {
-                const uint8_t zeros[16] = { 0 };
-                _poly1305.add(zeros, 16 - _ctextLen % 16);
-            }
-            updateLen(_ad.size());
+            aead.authenticate(in[i].data, in[i].len);
         }
-        updateLen(_ctextLen);
 
-        _ctextLen = 0;
-        _nonceLen = 0;
+        if(!aead.verify(macIn))
+        {
+            return false;
+        }
 
-        std::array<uint8_t, 16> mac;
-        _poly1305.finish(mac.data());
+        zip(in, inCount, out, outCount, [&](const std::uint8_t* in1, std::uint8_t* out1, std::size_t len)
+        {
+            aead._chaCha.cipher(in1, out1, len);
+        });
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::authenticate(const void* in, std::size_t len)
+    {
+        closeAd();
+
+        _poly1305.add(in, len); // poly1305 of ciphertext
+        _ctextLen += len;
+    }
 
-        const uint8_t* macIn1 = static_cast<const uint8_t* >(macIn);
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305::verify(const void* macIn)
+    {
+        std::array<uint8_t, 16> mac;
+        finish(mac.data());
 
-        uint8_t diff = 0;
+        return macsEqual(macIn, mac.data());
+    }
 
-        for(size_t i(0); i<mac.size(); ++i)
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305::closeAd()
+    {
+        if(!_adOpen)
         {
-            diff |= macIn1[i] ^ mac[i];
+            return;
         }
 
-        return 0 == diff;
+        _adOpen = false;
+
+        if(cfrgVersion())
+        {
+            if(_adLen % 16)
+            {
+                const uint8_t zeros[16] = { 0 };
+                _poly1305.add(zeros, 16 - _adLen % 16);
+            }
+        }
+        else
+        {
+            updateLen(_adLen);
+        }
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void ChaCha20Poly1305::clear()
+    void ChaCha20Poly1305::finish(void* mac)
     {
-        _chaCha.clear();
-        _poly1305.clear();
-        _ad.clear();
-        _nonceLen = 0;
+        closeAd();
+
+        if(cfrgVersion())
+        {
+            if(_ctextLen % 16)
+            {
+                const uint8_t zeros[16] = { 0 };
+                _poly1305.add(zeros, 16 - _ctextLen % 16);
+            }
+            updateLen(_adLen);
+        }
+        updateLen(_ctextLen);
+
+        _poly1305.finish(mac);
         _ctextLen = 0;
+        _nonceLen = 0;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     bool ChaCha20Poly1305::cfrgVersion() const
     {
-        return _nonceLen==12 || _nonceLen==24;
+        return cfrgNonce(_nonceLen);
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -9,6 +9,8 @@
 
 #include "chaCha.hpp"
 #include "poly1305.hpp"
+#include <dci/crypto/iov.hpp>
+#include <dci/crypto/chaCha20Poly1305Packet.hpp>
 #include <cstdint>
 #include <vector>
 
@@ -30,6 +32,7 @@ namespace dci::crypto::impl
         void setAd(const void* ad, std::size_t len);
 
         void start(const void* nonce, std::size_t len);
+        void addAd(const void* ad, std::size_t len);
 
         void encipher(const void* in, void* out, std::size_t len);
         void encipherFinish(void* macOut);
@@ -37,9 +40,40 @@ namespace dci::crypto::impl
         void decipher(const void* in, void* out, std::size_t len);
         bool decipherFinish(const void* macIn);
 
+        bool decipherVerified(const void* in, void* out, std::size_t len, const void* macIn);
+
         void clear();
 
+        static void seal(
+            const void* key, std::size_t keyLen,
+            const void* nonce, std::size_t nonceLen,
+            const void* ad, std::size_t adLen,
+            const ConstIov* in, std::size_t inCount,
+            const Iov* out, std::size_t outCount,
+            void* macOut);
+
+        static bool open(
+            const void* key, std::size_t keyLen,
+            const void* nonce, std::size_t nonceLen,
+            const void* ad, std::size_t adLen,
+            const ConstIov* in, std::size_t inCount,
+            const Iov* out, std::size_t outCount,
+            const void* macIn);
+
+        static void sealBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count);
+        static std::size_t openBatch(const void* key, std::size_t keyLen, const ChaCha20Poly1305Packet* packets, std::size_t count, std::uint64_t* valid);
+
     private:
+        friend class ChaCha20Poly1305Session;
+
+        void start(const void* nonce, std::size_t len, const void* ad, std::size_t adLen);
+
+        // poly1305 key known already, the cipher starts from block 1
+        void start(const void* nonce, std::size_t len, const void* ad, std::size_t adLen, const void* polyKey);
+        void authenticate(const void* in, std::size_t len);
+        bool verify(const void* macIn);
+        void closeAd();
+        void finish(void* mac);
         bool cfrgVersion() const;
         void updateLen(std::size_t);
 
@@ -47,6 +81,8 @@ namespace dci::crypto::impl
         ChaCha                      _chaCha;
         Poly1305                    _poly1305;
         std::vector<std::uint8_t>   _ad;
+        std::size_t                 _adLen = 0;
+        bool                        _adOpen = false;
         std::size_t                 _nonceLen = 0;
         std::size_t                 _ctextLen = 0;
     };
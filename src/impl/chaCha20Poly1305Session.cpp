@@ -0,0 +1,217 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "chaCha20Poly1305Session.hpp"
+#include <dci/utils/endian.hpp>
+#include <dci/utils/dbg.hpp>
+
+namespace dci::crypto::impl
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::ChaCha20Poly1305Session()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::ChaCha20Poly1305Session(const ChaCha20Poly1305Session& from)
+        : _aead{from._aead}
+        , _key{from._key}
+        , _keyLen{from._keyLen}
+        , _prefix{from._prefix}
+        , _counter{from._counter}
+        , _keys{from._keys}
+        , _keysFrom{from._keysFrom}
+        , _keysCount{from._keysCount}
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::ChaCha20Poly1305Session(ChaCha20Poly1305Session&& from)
+        : _aead{std::move(from._aead)}
+        , _key{std::move(from._key)}
+        , _keyLen{std::move(from._keyLen)}
+        , _prefix{std::move(from._prefix)}
+        , _counter{std::move(from._counter)}
+        , _keys{std::move(from._keys)}
+        , _keysFrom{std::move(from._keysFrom)}
+        , _keysCount{std::move(from._keysCount)}
+    {
+        from.clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session::~ChaCha20Poly1305Session()
+    {
+        clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session& ChaCha20Poly1305Session::operator=(const ChaCha20Poly1305Session& from)
+    {
+        _aead = from._aead;
+        _key = from._key;
+        _keyLen = from._keyLen;
+        _prefix = from._prefix;
+        _counter = from._counter;
+        _keys = from._keys;
+        _keysFrom = from._keysFrom;
+        _keysCount = from._keysCount;
+
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Session& ChaCha20Poly1305Session::operator=(ChaCha20Poly1305Session&& from)
+    {
+        _aead = std::move(from._aead);
+        _key = std::move(from._key);
+        _keyLen = std::move(from._keyLen);
+        _prefix = std::move(from._prefix);
+        _counter = std::move(from._counter);
+        _keys = std::move(from._keys);
+        _keysFrom = std::move(from._keysFrom);
+        _keysCount = std::move(from._keysCount);
+
+        from.clear();
+
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::setKey(const void* key, std::size_t len)
+    {
+        dbgAssert(len <= _key.size());
+
+        _key.fill(0);
+        memcpy(_key.data(), key, len);
+        _keyLen = len;
+        _keysCount = 0;
+
+        _aead.setKey(key, len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::setNoncePrefix(const void* prefix, std::size_t len)
+    {
+        dbgAssert(len <= _prefix.size());
+
+        _prefix.fill(0);
+        memcpy(_prefix.data(), prefix, len);
+        _keysCount = 0;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::setCounter(std::uint64_t counter)
+    {
+        _counter = counter;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint64_t ChaCha20Poly1305Session::counter() const
+    {
+        return _counter;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Session::seal(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, void* macOut)
+    {
+        if(exhausted())
+        {
+            return false;
+        }
+
+        start(ad, adLen);
+        _aead.encipher(in, out, len);
+        _aead.encipherFinish(macOut);
+
+        _counter++;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Session::open(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, const void* macIn)
+    {
+        if(exhausted())
+        {
+            return false;
+        }
+
+        start(ad, adLen);
+        if(!_aead.decipherVerified(in, out, len, macIn))
+        {
+            return false;
+        }
+
+        _counter++;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::clear()
+    {
+        _aead.clear();
+        _key.fill(0);
+        _keyLen = 0;
+        _prefix.fill(0);
+        _counter = 0;
+        _keys.fill(0);
+        _keysFrom = 0;
+        _keysCount = 0;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Session::exhausted() const
+    {
+        return _counter == ~std::uint64_t{};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::array<std::uint8_t, 12> ChaCha20Poly1305Session::nonce(std::uint64_t counter) const
+    {
+        std::array<std::uint8_t, 12> res;
+        memcpy(res.data(), _prefix.data(), 4);
+
+        const std::uint64_t counterLe = dci::utils::endian::n2l(counter);
+        memcpy(res.data() + 4, &counterLe, 8);
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Session::start(const void* ad, std::size_t adLen)
+    {
+        const std::array<std::uint8_t, 12> n = nonce(_counter);
+
+        const std::size_t lanes = std::min(ChaCha::lanes(20), keysAhead);
+        if(lanes < 2)
+        {
+            // nothing to share without chacha lanes
+            _aead.start(n.data(), n.size(), ad, adLen);
+            return;
+        }
+
+        if(_counter - _keysFrom >= _keysCount)
+        {
+            // block 0 of the next messages, one per chacha lane in a single pass; not past the
+            // last counter
+            _keysFrom = _counter;
+            _keysCount = static_cast<std::size_t>(std::min<std::uint64_t>(lanes - 1, ~std::uint64_t{} - _counter)) + 1;
+
+            std::array<std::array<std::uint8_t, 12>, keysAhead> nonces;
+            std::array<ChaChaJob, keysAhead> jobs;
+            for(std::size_t i(0); i<_keysCount; ++i)
+            {
+                nonces[i] = nonce(_keysFrom + i);
+                jobs[i] = ChaChaJob{_key.data(), _keyLen, nonces[i].data(), nonces[i].size(), 0, nullptr, _keys.data() + 32*i, 32};
+            }
+
+            ChaCha::cipherBatch(jobs.data(), _keysCount, 20);
+        }
+
+        _aead.start(n.data(), n.size(), ad, adLen, _keys.data() + 32*(_counter - _keysFrom));
+    }
+}
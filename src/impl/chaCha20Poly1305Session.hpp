@@ -0,0 +1,59 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "chaCha20Poly1305.hpp"
+#include <array>
+#include <cstdint>
+
+namespace dci::crypto::impl
+{
+    class ChaCha20Poly1305Session final
+    {
+    public:
+        ChaCha20Poly1305Session();
+        ChaCha20Poly1305Session(const ChaCha20Poly1305Session&);
+        ChaCha20Poly1305Session(ChaCha20Poly1305Session&&);
+        ~ChaCha20Poly1305Session();
+
+        ChaCha20Poly1305Session& operator=(const ChaCha20Poly1305Session&);
+        ChaCha20Poly1305Session& operator=(ChaCha20Poly1305Session&&);
+
+    public:
+        void setKey(const void* key, std::size_t len);
+        void setNoncePrefix(const void* prefix, std::size_t len);
+
+        void setCounter(std::uint64_t counter);
+        std::uint64_t counter() const;
+
+        bool seal(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, void* macOut);
+        bool open(const void* ad, std::size_t adLen, const void* in, void* out, std::size_t len, const void* macIn);
+
+        void clear();
+
+    private:
+        // poly1305 keys of messages drawn at once, one block each per chacha lane, up to the widest
+        static constexpr std::size_t keysAhead = 16;
+
+        bool exhausted() const;
+        std::array<std::uint8_t, 12> nonce(std::uint64_t counter) const;
+        void start(const void* ad, std::size_t adLen);
+
+    private:
+        ChaCha20Poly1305                            _aead;
+        std::array<std::uint8_t, 32>                _key {};
+        std::size_t                                 _keyLen = 0;
+        std::array<std::uint8_t, 4>                 _prefix {};
+        std::uint64_t                               _counter = 0;
+
+        // keys of messages [_keysFrom, _keysFrom + _keysCount)
+        std::array<std::uint8_t, 32*keysAhead>      _keys {};
+        std::uint64_t                               _keysFrom = 0;
+        std::size_t                                 _keysCount = 0;
+    };
+}
@@ -0,0 +1,283 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "chaCha20Poly1305Stream.hpp"
+#include "../cpu/parallel.hpp"
+#include <dci/utils/dbg.hpp>
+
+namespace dci::crypto::impl
+{
+    namespace
+    {
+        constexpr std::size_t macSize = 16;
+
+        // 32 bit chunk counter
+        constexpr std::uint64_t maxChunks = std::uint64_t{1} << 32;
+
+        // smaller shares are not worth a thread
+        constexpr std::size_t minBytesPerWorker = 256*1024;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::ChaCha20Poly1305Stream()
+        : _chunkSize{64*1024}
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::ChaCha20Poly1305Stream(const ChaCha20Poly1305Stream& from)
+        : _key{from._key}
+        , _keyLen{from._keyLen}
+        , _ad{from._ad}
+        , _chunkSize{from._chunkSize}
+        , _workers{from._workers}
+        , _prefix{from._prefix}
+        , _chunk{from._chunk}
+        , _done{from._done}
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::ChaCha20Poly1305Stream(ChaCha20Poly1305Stream&& from)
+        : _key{std::move(from._key)}
+        , _keyLen{std::move(from._keyLen)}
+        , _ad{std::move(from._ad)}
+        , _chunkSize{std::move(from._chunkSize)}
+        , _workers{std::move(from._workers)}
+        , _prefix{std::move(from._prefix)}
+        , _chunk{std::move(from._chunk)}
+        , _done{std::move(from._done)}
+    {
+        from.clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream::~ChaCha20Poly1305Stream()
+    {
+        clear();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream& ChaCha20Poly1305Stream::operator=(const ChaCha20Poly1305Stream& from)
+    {
+        _key = from._key;
+        _keyLen = from._keyLen;
+        _ad = from._ad;
+        _chunkSize = from._chunkSize;
+        _workers = from._workers;
+        _prefix = from._prefix;
+        _chunk = from._chunk;
+        _done = from._done;
+
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ChaCha20Poly1305Stream& ChaCha20Poly1305Stream::operator=(ChaCha20Poly1305Stream&& from)
+    {
+        _key = std::move(from._key);
+        _keyLen = std::move(from._keyLen);
+        _ad = std::move(from._ad);
+        _chunkSize = std::move(from._chunkSize);
+        _workers = std::move(from._workers);
+        _prefix = std::move(from._prefix);
+        _chunk = std::move(from._chunk);
+        _done = std::move(from._done);
+
+        from.clear();
+
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setKey(const void* key, std::size_t len)
+    {
+        dbgAssert(len <= _key.size());
+
+        _key.fill(0);
+        memcpy(_key.data(), key, len);
+        _keyLen = len;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setAd(const void* ad, std::size_t len)
+    {
+        const std::uint8_t* ad1 = static_cast<const std::uint8_t*>(ad);
+        _ad.assign(ad1, ad1 + len);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setChunkSize(std::size_t chunkSize)
+    {
+        dbgAssert(chunkSize);
+        _chunkSize = chunkSize;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::setWorkers(std::size_t workers)
+    {
+        _workers = workers;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::start(const void* prefix, std::size_t len)
+    {
+        dbgAssert(len <= _prefix.size());
+
+        _prefix.fill(0);
+        memcpy(_prefix.data(), prefix, len);
+        _chunk = 0;
+        _done = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Stream::seek(std::uint64_t chunk)
+    {
+        if(chunk >= maxChunks)
+        {
+            _done = true;
+            return false;
+        }
+
+        _chunk = chunk;
+        _done = false;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Stream::encipher(const void* in, std::size_t len, void* out, bool last)
+    {
+        const std::size_t count = std::max(std::size_t{1}, len / _chunkSize + (len % _chunkSize ? 1 : 0));
+
+        if(_done || (!last && (!len || len % _chunkSize)) || count > maxChunks - _chunk)
+        {
+            // nothing may follow, not whole chunks, or chunk numbers (and so nonces) would wrap
+            _done = true;
+            return false;
+        }
+
+        const std::uint8_t* in1 = static_cast<const std::uint8_t*>(in);
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        forChunks(count, [&](std::size_t i)
+        {
+            const bool lastChunk = last && i == count-1;
+            const std::size_t size = lastChunk ? len - i*_chunkSize : _chunkSize;
+            const std::array<std::uint8_t, 12> n = nonce(_chunk + i, lastChunk);
+
+            std::uint8_t* sealed = out1 + i*(_chunkSize + macSize);
+            const ConstIov textIn {in1 + i*_chunkSize, size};
+            const Iov textOut {sealed, size};
+            ChaCha20Poly1305::seal(_key.data(), _keyLen, n.data(), n.size(), _ad.data(), _ad.size(), &textIn, 1, &textOut, 1, sealed + size);
+        });
+
+        _chunk += count;
+        _done = last;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool ChaCha20Poly1305Stream::decipher(const void* in, std::size_t len, void* out, bool last)
+    {
+        const std::size_t sealedChunk = _chunkSize + macSize;
+
+        if(_done || (!last && (!len || len % sealedChunk)) || (last && len % sealedChunk && len % sealedChunk < macSize))
+        {
+            // not whole chunks, or nothing may follow
+            _done = true;
+            return false;
+        }
+
+        const std::uint8_t* in1 = static_cast<const std::uint8_t*>(in);
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        const std::size_t count = (len + sealedChunk - 1) / sealedChunk;
+        if(!count || _chunk + count > maxChunks)
+        {
+            _done = true;
+            return false;
+        }
+
+        // each chunk is verified before it is deciphered, a forged one leaves its out untouched
+        std::vector<std::uint8_t> authentic(count);
+        forChunks(count, [&](std::size_t i)
+        {
+            const bool lastChunk = last && i == count-1;
+            const std::size_t size = (lastChunk ? len - i*sealedChunk : sealedChunk) - macSize;
+            const std::array<std::uint8_t, 12> n = nonce(_chunk + i, lastChunk);
+
+            const std::uint8_t* sealed = in1 + i*sealedChunk;
+            const ConstIov textIn {sealed, size};
+            const Iov textOut {out1 + i*_chunkSize, size};
+            authentic[i] = ChaCha20Poly1305::open(_key.data(), _keyLen, n.data(), n.size(), _ad.data(), _ad.size(), &textIn, 1, &textOut, 1, sealed + size) ? 1 : 0;
+        });
+
+        _chunk += count;
+        _done = last;
+
+        for(std::uint8_t ok : authentic)
+        {
+            if(!ok)
+            {
+                _done = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ChaCha20Poly1305Stream::clear()
+    {
+        _key.fill(0);
+        _keyLen = 0;
+        _ad.clear();
+        _prefix.fill(0);
+        _chunk = 0;
+        _done = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint64_t ChaCha20Poly1305Stream::sealedSize(std::uint64_t len, std::size_t chunkSize)
+    {
+        const std::uint64_t count = std::max(std::uint64_t{1}, (len + chunkSize - 1) / chunkSize);
+        return len + count*macSize;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::array<std::uint8_t, 12> ChaCha20Poly1305Stream::nonce(std::uint64_t chunk, bool last) const
+    {
+        std::array<std::uint8_t, 12> res;
+        memcpy(res.data(), _prefix.data(), 7);
+
+        res[ 7] = static_cast<std::uint8_t>(chunk >> 24);
+        res[ 8] = static_cast<std::uint8_t>(chunk >> 16);
+        res[ 9] = static_cast<std::uint8_t>(chunk >> 8);
+        res[10] = static_cast<std::uint8_t>(chunk);
+
+        res[11] = last ? 1 : 0;
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <class F>
+    void ChaCha20Poly1305Stream::forChunks(std::size_t count, F&& f) const
+    {
+        std::size_t workers = _workers ? _workers : cpu::poolConcurrency();
+        workers = std::max(std::size_t{1}, std::min(workers, count*_chunkSize / minBytesPerWorker));
+
+        cpu::parallel(count, workers, [&](std::size_t begin, std::size_t end)
+        {
+            for(std::size_t i(begin); i<end; ++i)
+            {
+                f(i);
+            }
+        });
+    }
+}
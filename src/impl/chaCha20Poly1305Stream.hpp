@@ -0,0 +1,62 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "chaCha20Poly1305.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace dci::crypto::impl
+{
+    class ChaCha20Poly1305Stream final
+    {
+    public:
+        ChaCha20Poly1305Stream();
+        ChaCha20Poly1305Stream(const ChaCha20Poly1305Stream&);
+        ChaCha20Poly1305Stream(ChaCha20Poly1305Stream&&);
+        ~ChaCha20Poly1305Stream();
+
+        ChaCha20Poly1305Stream& operator=(const ChaCha20Poly1305Stream&);
+        ChaCha20Poly1305Stream& operator=(ChaCha20Poly1305Stream&&);
+
+    public:
+        void setKey(const void* key, std::size_t len);
+        void setAd(const void* ad, std::size_t len);
+        void setChunkSize(std::size_t chunkSize);
+        void setWorkers(std::size_t workers);
+
+        void start(const void* prefix, std::size_t len);
+        bool seek(std::uint64_t chunk);
+
+        bool encipher(const void* in, std::size_t len, void* out, bool last);
+        bool decipher(const void* in, std::size_t len, void* out, bool last);
+
+        void clear();
+
+        static std::uint64_t sealedSize(std::uint64_t len, std::size_t chunkSize);
+
+    private:
+        std::array<std::uint8_t, 12> nonce(std::uint64_t chunk, bool last) const;
+
+        // chunks [0, count) of a call, f(index) for each, spread over the workers
+        template <class F>
+        void forChunks(std::size_t count, F&& f) const;
+
+    private:
+        std::array<std::uint8_t, 32>    _key {};
+        std::size_t                     _keyLen = 0;
+        std::vector<std::uint8_t>       _ad;
+        std::size_t                     _chunkSize;
+        std::size_t                     _workers = 0;
+
+        std::array<std::uint8_t, 7>     _prefix {};
+        std::uint64_t                   _chunk = 0;
+        bool                            _done = false;
+    };
+}
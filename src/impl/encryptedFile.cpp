@@ -0,0 +1,529 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "encryptedFile.hpp"
+#include "../cpu/parallel.hpp"
+#include <dci/crypto/rnd.hpp>
+#include <dci/utils/endian.hpp>
+#include <dci/utils/dbg.hpp>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <errno.h>
+#endif
+
+namespace dci::crypto::impl
+{
+    namespace
+    {
+        // header: magic, segment size (le32), nonce prefix, zero, plaintext size (le64), zeros
+        constexpr char magic[8] = {'d', 'c', 'i', '.', 's', 'e', 'g', '1'};
+        constexpr std::size_t segmentSizeAt = 8;
+        constexpr std::size_t prefixAt = 12;
+        constexpr std::size_t prefixSize = 7;
+        constexpr std::size_t sizeAt = 20;
+
+        // 32 bit chunk counter of the stream
+        constexpr std::uint64_t maxSegments = std::uint64_t{1} << 32;
+
+        std::uint64_t segmentsFor(std::uint64_t size, std::size_t segmentSize)
+        {
+            return std::max(std::uint64_t{1}, (size + segmentSize - 1) / segmentSize);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile::EncryptedFile()
+    {
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile::EncryptedFile(EncryptedFile&& from)
+    {
+        *this = std::move(from);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile::~EncryptedFile()
+    {
+        close();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    EncryptedFile& EncryptedFile::operator=(EncryptedFile&& from)
+    {
+        if(this == &from)
+        {
+            return *this;
+        }
+
+        close();
+
+#if defined(_WIN32)
+        _file = std::exchange(from._file, nullptr);
+        _mapping = std::exchange(from._mapping, nullptr);
+#else
+        _fd = std::exchange(from._fd, -1);
+#endif
+        _map = std::exchange(from._map, nullptr);
+        _mapSize = std::exchange(from._mapSize, 0);
+        _writable = std::exchange(from._writable, false);
+
+        _stream = std::move(from._stream);
+        _size = std::exchange(from._size, 0);
+        _segmentSize = std::exchange(from._segmentSize, 0);
+        _segments = std::exchange(from._segments, 0);
+
+        _next = std::exchange(from._next, 0);
+        _fill = std::exchange(from._fill, 0);
+        _written = std::exchange(from._written, 0);
+
+        _buffer = std::move(from._buffer);
+
+        return *this;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::create(const char* path, const void* key, std::size_t keyLen, std::uint64_t size, std::size_t segmentSize)
+    {
+        close();
+
+        if(!layoutFits(size, segmentSize))
+        {
+            return false;
+        }
+
+        std::uint8_t header[headerSize] {};
+        memcpy(header, magic, sizeof(magic));
+
+        const std::uint32_t segmentSizeLe = dci::utils::endian::n2l(static_cast<std::uint32_t>(segmentSize));
+        memcpy(header + segmentSizeAt, &segmentSizeLe, 4);
+
+        if(!rnd::generate(header + prefixAt, prefixSize))
+        {
+            return false;
+        }
+
+        const std::uint64_t sizeLe = dci::utils::endian::n2l(size);
+        memcpy(header + sizeAt, &sizeLe, 8);
+
+        if(!map(path, headerSize + ChaCha20Poly1305Stream::sealedSize(size, segmentSize), true))
+        {
+            return false;
+        }
+
+        memcpy(_map, header, headerSize);
+        setup(header, key, keyLen);
+
+        if(!size)
+        {
+            // an empty object is one empty chunk
+            if(!_stream.seek(0) || !_stream.encipher(nullptr, 0, segment(0), true))
+            {
+                close();
+                return false;
+            }
+            _next = 1;
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::write(const void* data, std::size_t len)
+    {
+        if(!_writable || len > _size - _written)
+        {
+            return false;
+        }
+
+        const std::uint8_t* data1 = static_cast<const std::uint8_t*>(data);
+        const std::uint64_t lastSegment = _segments - 1;
+
+        while(len)
+        {
+            const std::size_t segLen = segmentLen(_next);
+
+            if(!_fill && _next < lastSegment && len >= _segmentSize)
+            {
+                // whole segments straight from data, in parallel
+                const std::uint64_t count = std::min(std::uint64_t{len / _segmentSize}, lastSegment - _next);
+                const std::size_t bytes = static_cast<std::size_t>(count) * _segmentSize;
+
+                if(!_stream.seek(_next) || !_stream.encipher(data1, bytes, segment(_next), false))
+                {
+                    return false;
+                }
+
+                _next += count;
+                _written += bytes;
+                data1 += bytes;
+                len -= bytes;
+                continue;
+            }
+
+            // staged in the private buffer, the shared mapping only ever sees ciphertext
+            _buffer.resize(_segmentSize);
+
+            const std::size_t size = std::min(len, segLen - _fill);
+            memcpy(_buffer.data() + _fill, data1, size);
+            _fill += size;
+            _written += size;
+            data1 += size;
+            len -= size;
+
+            if(_fill == segLen)
+            {
+                const bool sealed = _stream.seek(_next) && _stream.encipher(_buffer.data(), segLen, segment(_next), _next == lastSegment);
+                std::fill(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(segLen), 0);
+
+                if(!sealed)
+                {
+                    return false;
+                }
+
+                _next++;
+                _fill = 0;
+            }
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::open(const char* path, const void* key, std::size_t keyLen)
+    {
+        close();
+
+        if(!map(path, 0, false))
+        {
+            return false;
+        }
+
+        std::uint32_t segmentSizeLe;
+        std::uint64_t sizeLe;
+        if(_mapSize >= headerSize)
+        {
+            memcpy(&segmentSizeLe, _map + segmentSizeAt, 4);
+            memcpy(&sizeLe, _map + sizeAt, 8);
+        }
+
+        const std::size_t segmentSize = _mapSize >= headerSize ? dci::utils::endian::n2l(segmentSizeLe) : 0;
+        const std::uint64_t size = _mapSize >= headerSize ? dci::utils::endian::n2l(sizeLe) : 0;
+
+        if(_mapSize < headerSize ||
+           memcmp(_map, magic, sizeof(magic)) ||
+           !layoutFits(size, segmentSize) ||
+           _mapSize - headerSize != ChaCha20Poly1305Stream::sealedSize(size, segmentSize))
+        {
+            close();
+            return false;
+        }
+
+        setup(_map, key, keyLen);
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint64_t EncryptedFile::size() const
+    {
+        return _size;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::read(std::uint64_t offset, void* out, std::size_t len)
+    {
+        if(!_map || _writable || offset > _size || len > _size - offset)
+        {
+            return false;
+        }
+
+        std::uint8_t* out1 = static_cast<std::uint8_t*>(out);
+
+        std::uint64_t index = offset / _segmentSize;
+        std::size_t skip = static_cast<std::size_t>(offset % _segmentSize);
+
+        while(len)
+        {
+            if(!skip && len >= segmentLen(index))
+            {
+                // fully covered segments straight into out
+                std::uint64_t count = 0;
+                std::size_t bytes = 0;
+                while(index + count < _segments && len - bytes >= segmentLen(index + count))
+                {
+                    bytes += segmentLen(index + count);
+                    count++;
+                }
+
+                if(!decipher(index, count, out1))
+                {
+                    return false;
+                }
+
+                index += count;
+                out1 += bytes;
+                len -= bytes;
+                continue;
+            }
+
+            // an edge of the range, opened in place in the buffer
+            _buffer.resize(_segmentSize + macSize);
+            if(!decipher(index, 1, _buffer.data()))
+            {
+                return false;
+            }
+
+            const std::size_t size = std::min(len, segmentLen(index) - skip);
+            memcpy(out1, _buffer.data() + skip, size);
+
+            index++;
+            skip = 0;
+            out1 += size;
+            len -= size;
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::close()
+    {
+        const bool complete = !_writable || _next == _segments;
+
+        unmap();
+
+        _stream.clear();
+        _size = 0;
+        _segmentSize = 0;
+        _segments = 0;
+        _next = 0;
+        _fill = 0;
+        _written = 0;
+
+        std::fill(_buffer.begin(), _buffer.end(), 0);
+        _buffer.clear();
+
+        return complete;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::map(const char* path, std::uint64_t size, bool writable)
+    {
+#if defined(_WIN32)
+        _file = CreateFileA(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(INVALID_HANDLE_VALUE == _file)
+        {
+            _file = nullptr;
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if(writable)
+        {
+            fileSize.QuadPart = static_cast<LONGLONG>(size);
+            if(!SetFilePointerEx(_file, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(_file))
+            {
+                unmap();
+                return false;
+            }
+        }
+        else
+        {
+            if(!GetFileSizeEx(_file, &fileSize))
+            {
+                unmap();
+                return false;
+            }
+            size = static_cast<std::uint64_t>(fileSize.QuadPart);
+        }
+
+        _mapping = size ? CreateFileMappingA(_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr) : nullptr;
+        void* view = _mapping ? MapViewOfFile(_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if(!view)
+        {
+            unmap();
+            return false;
+        }
+#else
+        _fd = writable ?
+                  ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) :
+                  ::open(path, O_RDONLY | O_CLOEXEC);
+        if(0 > _fd)
+        {
+            return false;
+        }
+
+        if(writable)
+        {
+            if(0 != ::ftruncate(_fd, static_cast<off_t>(size)))
+            {
+                unmap();
+                return false;
+            }
+        }
+        else
+        {
+            struct stat st;
+            if(0 != ::fstat(_fd, &st))
+            {
+                unmap();
+                return false;
+            }
+            size = static_cast<std::uint64_t>(st.st_size);
+        }
+
+        void* view = size ? ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _fd, 0) : MAP_FAILED;
+        if(MAP_FAILED == view)
+        {
+            unmap();
+            return false;
+        }
+
+        if(!writable)
+        {
+            // reads touch a few segments here and there
+            ::madvise(view, size, MADV_RANDOM);
+        }
+#endif
+
+        _map = static_cast<std::uint8_t*>(view);
+        _mapSize = size;
+        _writable = writable;
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void EncryptedFile::unmap()
+    {
+#if defined(_WIN32)
+        if(_map)
+        {
+            UnmapViewOfFile(_map);
+        }
+
+        if(_mapping)
+        {
+            CloseHandle(_mapping);
+            _mapping = nullptr;
+        }
+
+        if(_file)
+        {
+            CloseHandle(_file);
+            _file = nullptr;
+        }
+#else
+        if(_map)
+        {
+            ::munmap(_map, _mapSize);
+        }
+
+        if(0 <= _fd)
+        {
+            while(0!=::close(_fd) && EINTR == errno);
+            _fd = -1;
+        }
+#endif
+
+        _map = nullptr;
+        _mapSize = 0;
+        _writable = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void EncryptedFile::setup(const std::uint8_t header[headerSize], const void* key, std::size_t keyLen)
+    {
+        std::uint32_t segmentSizeLe;
+        memcpy(&segmentSizeLe, header + segmentSizeAt, 4);
+        _segmentSize = dci::utils::endian::n2l(segmentSizeLe);
+
+        std::uint64_t sizeLe;
+        memcpy(&sizeLe, header + sizeAt, 8);
+        _size = dci::utils::endian::n2l(sizeLe);
+
+        _segments = segmentsFor(_size, _segmentSize);
+
+        // the header goes with every segment, a changed size or segment size breaks them all
+        _stream.setKey(key, keyLen);
+        _stream.setAd(header, headerSize);
+        _stream.setChunkSize(_segmentSize);
+        _stream.start(header + prefixAt, prefixSize);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::layoutFits(std::uint64_t size, std::size_t segmentSize)
+    {
+        // the round up to whole segments and the sealed size with the header must not wrap, a
+        // hostile header could otherwise pass for a tiny file
+        constexpr std::uint64_t max = ~std::uint64_t{};
+
+        if(!segmentSize || segmentSize > 0xffffffff || size > max - (segmentSize - 1))
+        {
+            return false;
+        }
+
+        const std::uint64_t segments = segmentsFor(size, segmentSize);
+        return segments <= maxSegments && size <= max - headerSize - segments * macSize;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::uint8_t* EncryptedFile::segment(std::uint64_t index) const
+    {
+        return _map + headerSize + index * (_segmentSize + macSize);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t EncryptedFile::segmentLen(std::uint64_t index) const
+    {
+        return index + 1 < _segments ? _segmentSize : static_cast<std::size_t>(_size - (_segments - 1) * _segmentSize);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool EncryptedFile::decipher(std::uint64_t first, std::uint64_t count, std::uint8_t* out)
+    {
+        dbgAssert(count && first + count <= _segments);
+
+        // the mapping is shared and the mac check reads the ciphertext before the keystream pass
+        // does, a writer could flip bits in between and have them pass as authentic; segments are
+        // opened from a private copy, a pool's worth at a time
+        const std::uint64_t batch = cpu::poolConcurrency();
+
+        while(count)
+        {
+            const std::uint64_t n = std::min(count, batch);
+            const std::uint64_t last = first + n - 1;
+            const std::size_t sealedLen = static_cast<std::size_t>(last - first) * (_segmentSize + macSize) + segmentLen(last) + macSize;
+
+            if(_buffer.size() < sealedLen)
+            {
+                _buffer.resize(sealedLen);
+            }
+            memcpy(_buffer.data(), segment(first), sealedLen);
+
+            if(!_stream.seek(first) || !_stream.decipher(_buffer.data(), sealedLen, out, last == _segments - 1))
+            {
+                return false;
+            }
+
+            first += n;
+            count -= n;
+            out += static_cast<std::size_t>(n) * _segmentSize;
+        }
+
+        return true;
+    }
+}
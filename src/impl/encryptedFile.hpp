@@ -0,0 +1,77 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "chaCha20Poly1305Stream.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace dci::crypto::impl
+{
+    class EncryptedFile final
+    {
+    public:
+        EncryptedFile();
+        EncryptedFile(const EncryptedFile&) = delete;
+        EncryptedFile(EncryptedFile&&);
+        ~EncryptedFile();
+
+        EncryptedFile& operator=(const EncryptedFile&) = delete;
+        EncryptedFile& operator=(EncryptedFile&&);
+
+    public:
+        bool create(const char* path, const void* key, std::size_t keyLen, std::uint64_t size, std::size_t segmentSize);
+        bool write(const void* data, std::size_t len);
+
+        bool open(const char* path, const void* key, std::size_t keyLen);
+        std::uint64_t size() const;
+        bool read(std::uint64_t offset, void* out, std::size_t len);
+
+        bool close();
+
+    private:
+        static constexpr std::size_t headerSize = 32;
+        static constexpr std::size_t macSize = 16;
+
+        bool map(const char* path, std::uint64_t size, bool writable);
+        void unmap();
+        void setup(const std::uint8_t header[headerSize], const void* key, std::size_t keyLen);
+        static bool layoutFits(std::uint64_t size, std::size_t segmentSize);
+
+        std::uint8_t* segment(std::uint64_t index) const;
+        std::size_t segmentLen(std::uint64_t index) const;
+
+        // count whole segments from first into out, the last one of the file may be among them; out
+        // may be the buffer itself for a single segment
+        bool decipher(std::uint64_t first, std::uint64_t count, std::uint8_t* out);
+
+    private:
+#if defined(_WIN32)
+        void*                       _file = nullptr;
+        void*                       _mapping = nullptr;
+#else
+        int                         _fd = -1;
+#endif
+        std::uint8_t*               _map = nullptr;
+        std::uint64_t               _mapSize = 0;
+        bool                        _writable = false;
+
+        ChaCha20Poly1305Stream      _stream;
+        std::uint64_t               _size = 0;
+        std::size_t                 _segmentSize = 0;
+        std::uint64_t               _segments = 0;
+
+        // writing: next segment to seal, plaintext staged for it and in total
+        std::uint64_t               _next = 0;
+        std::size_t                 _fill = 0;
+        std::uint64_t               _written = 0;
+
+        // a partly written segment, sealed segments being read
+        std::vector<std::uint8_t>   _buffer;
+    };
+}
@@ -9,9 +9,212 @@
 #include <dci/crypto/poly1305.hpp>
 #include <dci/utils/endian.hpp>
 #include <dci/utils/dbg.hpp>
+#include "poly1305/kernels.hpp"
+#include "../cpu/dispatch.hpp"
 
 namespace dci::crypto::impl
 {
+    namespace
+    {
+        void poly1305_blocks_generic(uint64_t poly[poly1305::stateSize], const void* m, size_t blocks, bool is_final)
+        {
+            const uint64_t* m8 = static_cast<const uint64_t*>(m);
+
+            typedef unsigned uint128_t __attribute__((mode(TI)));
+
+            const uint64_t hibit = is_final ? 0 : (static_cast<uint64_t>(1) << 40); /* 1 << 128 */
+
+            const uint64_t r0 = poly[0];
+            const uint64_t r1 = poly[1];
+            const uint64_t r2 = poly[2];
+
+            const uint64_t M44 = 0xFFFFFFFFFFF;
+            const uint64_t M42 = 0x3FFFFFFFFFF;
+
+            uint64_t h0 = poly[3+0];
+            uint64_t h1 = poly[3+1];
+            uint64_t h2 = poly[3+2];
+
+            const uint64_t s1 = r1 * 20;
+            const uint64_t s2 = r2 * 20;
+
+            for(size_t i = 0; i != blocks; ++i)
+            {
+                const uint64_t t0 = dci::utils::endian::n2l(m8[0]);
+                const uint64_t t1 = dci::utils::endian::n2l(m8[1]);
+
+                h0 += (( t0                    ) & M44);
+                h1 += (((t0 >> 44) | (t1 << 20)) & M44);
+                h2 += (((t1 >> 24)             ) & M42) | hibit;
+
+                const uint128_t d0 = uint128_t(h0) * r0 + uint128_t(h1) * s2 + uint128_t(h2) * s1;
+                const uint64_t c0 = static_cast<uint64_t>(d0 >> 44);
+
+                const uint128_t d1 = uint128_t(h0) * r1 + uint128_t(h1) * r0 + uint128_t(h2) * s2 + c0;
+                const uint64_t c1 = static_cast<uint64_t>(d1 >> 44);
+
+                const uint128_t d2 = uint128_t(h0) * r2 + uint128_t(h1) * r1 + uint128_t(h2) * r0 + c1;
+                const uint64_t c2 = static_cast<uint64_t>(d2 >> 42);
+
+                h0 = d0 & M44;
+                h1 = d1 & M44;
+                h2 = d2 & M42;
+
+                h0 += c2 * 5;
+                h1 += uint128_t{h0} >> 44;
+                h0 = h0 & M44;
+                m8 += 2;
+            }
+
+            poly[3+0] = h0;
+            poly[3+1] = h1;
+            poly[3+2] = h2;
+        }
+
+        using Blocks = void (*)(uint64_t poly[poly1305::stateSize], const void* m, size_t blocks, bool is_final);
+
+        // short inputs, tails of the vector paths and the final block
+        Blocks scalarImpl = &poly1305_blocks_generic;
+
+        std::string_view scalarBind()
+        {
+#if defined(__x86_64__)
+            // needs only bmi2/adx, so it is not tied to the vector tiers
+            if(cpu::use(cpu::Tier::ssse3, cpu::bmi2 | cpu::adx))
+            {
+                scalarImpl = &poly1305::poly1305_blocks_mulx;
+                return "mulx";
+            }
+#endif
+
+            scalarImpl = &poly1305_blocks_generic;
+            return "generic";
+        }
+
+        const cpu::Binder scalarBinder {"poly1305.scalar", &scalarBind};
+
+#if defined(__x86_64__) || defined(__i386__)
+        // below this the conversions around the vector loop cost more than they save
+        constexpr size_t avx2MinBlocks = 16;
+
+        void poly1305_blocks_avx2(uint64_t poly[poly1305::stateSize], const void* m, size_t blocks, bool is_final)
+        {
+            if(!is_final && blocks >= avx2MinBlocks)
+            {
+                const size_t bulk = blocks & ~size_t{3};
+                poly1305::poly1305_blocks4_avx2(poly, m, bulk);
+                m = static_cast<const uint8_t*>(m) + bulk*16;
+                blocks -= bulk;
+            }
+
+            scalarImpl(poly, m, blocks, is_final);
+        }
+
+        constexpr size_t avx512ifmaMinBlocks = 32;
+
+        void poly1305_blocks_avx512ifma(uint64_t poly[poly1305::stateSize], const void* m, size_t blocks, bool is_final)
+        {
+            if(!is_final && blocks >= avx512ifmaMinBlocks)
+            {
+                const size_t bulk = blocks & ~size_t{7};
+                poly1305::poly1305_blocks8_avx512ifma(poly, m, bulk);
+                m = static_cast<const uint8_t*>(m) + bulk*16;
+                blocks -= bulk;
+            }
+
+            poly1305_blocks_avx2(poly, m, blocks, is_final);
+        }
+#endif
+
+        void poly1305_blocks_scalar(uint64_t poly[poly1305::stateSize], const void* m, size_t blocks, bool is_final)
+        {
+            scalarImpl(poly, m, blocks, is_final);
+        }
+
+        using Lanes = void (*)(uint64_t* const states[], const uint8_t* const m[], size_t blocks);
+
+        void poly1305_lanes1_scalar(uint64_t* const states[1], const uint8_t* const m[1], size_t blocks)
+        {
+            if(m[0])
+            {
+                scalarImpl(states[0], m[0], blocks, false);
+            }
+        }
+
+        Blocks blocksImpl = &poly1305_blocks_scalar;
+        Lanes lanesImpl = &poly1305_lanes1_scalar;
+        size_t lanesWidth = 1;
+
+        std::string_view blocksBind()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if(cpu::use(cpu::Tier::avx512, cpu::avx2 | cpu::avx512f | cpu::avx512ifma))
+            {
+                blocksImpl = &poly1305_blocks_avx512ifma;
+                lanesImpl = &poly1305::poly1305_lanes8_avx512ifma;
+                lanesWidth = 8;
+                return "avx512ifma";
+            }
+
+            if(cpu::use(cpu::Tier::avx2, cpu::avx2))
+            {
+                blocksImpl = &poly1305_blocks_avx2;
+                lanesImpl = &poly1305::poly1305_lanes4_avx2;
+                lanesWidth = 4;
+                return "avx2";
+            }
+#endif
+
+            blocksImpl = &poly1305_blocks_scalar;
+            lanesImpl = &poly1305_lanes1_scalar;
+            lanesWidth = 1;
+            return "scalar";
+        }
+
+        const cpu::Binder blocksBinder {"poly1305", &blocksBind};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poly1305::powers(uint64_t state[stateSize], size_t upTo)
+    {
+        dbgAssert(upTo <= maxPower);
+
+        typedef unsigned uint128_t __attribute__((mode(TI)));
+
+        const uint64_t M44 = 0xFFFFFFFFFFF;
+        const uint64_t M42 = 0x3FFFFFFFFFF;
+
+        const uint64_t r0 = state[0];
+        const uint64_t r1 = state[1];
+        const uint64_t r2 = state[2];
+
+        const uint64_t s1 = r1 * 20;
+        const uint64_t s2 = r2 * 20;
+
+        for(size_t k = std::max(state[8], uint64_t{1}); k < upTo; ++k)
+        {
+            /* r^(k+1) = r^k * r */
+            const uint64_t* a = power(state, k);
+            uint64_t* p = power(state, k+1);
+
+            const uint128_t d0 = uint128_t(a[0]) * r0 + uint128_t(a[1]) * s2 + uint128_t(a[2]) * s1;
+            const uint64_t c0 = static_cast<uint64_t>(d0 >> 44);
+
+            const uint128_t d1 = uint128_t(a[0]) * r1 + uint128_t(a[1]) * r0 + uint128_t(a[2]) * s2 + c0;
+            const uint64_t c1 = static_cast<uint64_t>(d1 >> 44);
+
+            const uint128_t d2 = uint128_t(a[0]) * r2 + uint128_t(a[1]) * r1 + uint128_t(a[2]) * r0 + c1;
+            const uint64_t c2 = static_cast<uint64_t>(d2 >> 42);
+
+            uint64_t h0 = (d0 & M44) + c2 * 5;
+            p[1] = (d1 & M44) + (h0 >> 44);
+            p[0] = h0 & M44;
+            p[2] = d2 & M42;
+
+            state[8] = k+1;
+        }
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     Poly1305::Poly1305()
         : Mac{16}
@@ -103,6 +306,9 @@ namespace dci::crypto::impl
         /* save pad for later */
         _poly[6] = dci::utils::endian::n2l(key8[2]);
         _poly[7] = dci::utils::endian::n2l(key8[3]);
+
+        /* powers of r are computed on demand */
+        _poly[8] = 1;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -135,8 +341,11 @@ namespace dci::crypto::impl
             blocks(input, fullBlocks);
         }
 
-        memcpy(_buf.data()+_bufPos, input + fullBlocks * _buf.size(), remaining);
-        _bufPos += remaining;
+        if(remaining)
+        {
+            memcpy(_buf.data()+_bufPos, input + fullBlocks * _buf.size(), remaining);
+            _bufPos += remaining;
+        }
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -228,65 +437,37 @@ namespace dci::crypto::impl
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void Poly1305::clear()
     {
-        _poly = std::array<uint64_t, 8>{};
+        _poly = std::array<uint64_t, poly1305::stateSize>{};
         _buf = std::array<uint8_t, 16>{};
         _bufPos = 0;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void Poly1305::blocks(const void* m, std::size_t blocks, bool is_final)
+    std::size_t Poly1305::lanes()
     {
-        const uint64_t* m8 = static_cast<const uint64_t*>(m);
-
-        typedef unsigned uint128_t __attribute__((mode(TI)));
-
-        const uint64_t hibit = is_final ? 0 : (static_cast<uint64_t>(1) << 40); /* 1 << 128 */
-
-        const uint64_t r0 = _poly[0];
-        const uint64_t r1 = _poly[1];
-        const uint64_t r2 = _poly[2];
-
-        const uint64_t M44 = 0xFFFFFFFFFFF;
-        const uint64_t M42 = 0x3FFFFFFFFFF;
-
-        uint64_t h0 = _poly[3+0];
-        uint64_t h1 = _poly[3+1];
-        uint64_t h2 = _poly[3+2];
+        return lanesWidth;
+    }
 
-        const uint64_t s1 = r1 * 20;
-        const uint64_t s2 = r2 * 20;
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Poly1305::addLanes(Poly1305* const macs[], const void* const data[], std::size_t blocks)
+    {
+        std::array<uint64_t*, maxLanes> states;
+        std::array<const uint8_t*, maxLanes> m;
 
-        for(size_t i = 0; i != blocks; ++i)
+        for(std::size_t j(0); j<lanesWidth; ++j)
         {
-            const uint64_t t0 = dci::utils::endian::n2l(m8[0]);
-            const uint64_t t1 = dci::utils::endian::n2l(m8[1]);
-
-            h0 += (( t0                    ) & M44);
-            h1 += (((t0 >> 44) | (t1 << 20)) & M44);
-            h2 += (((t1 >> 24)             ) & M42) | hibit;
-
-            const uint128_t d0 = uint128_t(h0) * r0 + uint128_t(h1) * s2 + uint128_t(h2) * s1;
-            const uint64_t c0 = static_cast<uint64_t>(d0 >> 44);
-
-            const uint128_t d1 = uint128_t(h0) * r1 + uint128_t(h1) * r0 + uint128_t(h2) * s2 + c0;
-            const uint64_t c1 = static_cast<uint64_t>(d1 >> 44);
-
-            const uint128_t d2 = uint128_t(h0) * r2 + uint128_t(h1) * r1 + uint128_t(h2) * r0 + c1;
-            const uint64_t c2 = static_cast<uint64_t>(d2 >> 42);
-
-            h0 = d0 & M44;
-            h1 = d1 & M44;
-            h2 = d2 & M42;
-
-            h0 += c2 * 5;
-            h1 += uint128_t{h0} >> 44;
-            h0 = h0 & M44;
-            m8 += 2;
+            dbgAssert(!macs[j] || !macs[j]->_bufPos);
+            states[j] = macs[j] ? macs[j]->_poly.data() : nullptr;
+            m[j] = macs[j] ? static_cast<const uint8_t*>(data[j]) : nullptr;
         }
 
-        _poly[3+0] = h0;
-        _poly[3+1] = h1;
-        _poly[3+2] = h2;
+        lanesImpl(states.data(), m.data(), blocks);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Poly1305::blocks(const void* m, std::size_t blocks, bool is_final)
+    {
+        blocksImpl(_poly.data(), m, blocks, is_final);
     }
 }
 
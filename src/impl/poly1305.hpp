@@ -8,6 +8,7 @@
 #pragma once
 
 #include "mac.hpp"
+#include "poly1305/kernels.hpp"
 #include <array>
 
 namespace dci::crypto::impl
@@ -34,11 +35,17 @@ namespace dci::crypto::impl
         void finish(void* digest, std::size_t customDigestSize) override;
         void clear() override;
 
+        // several independent macs at once, one per simd lane: macs[j] absorbs 16*blocks bytes
+        // from data[j], null macs are skipped; none of the macs may hold a partial block
+        static constexpr std::size_t maxLanes = 8;
+        static std::size_t lanes();
+        static void addLanes(Poly1305* const macs[], const void* const data[], std::size_t blocks);
+
     private:
         void blocks(const void* m, std::size_t blocks, bool is_final = false);
 
     private:
-        std::array<uint64_t, 8> _poly;
+        std::array<uint64_t, poly1305::stateSize> _poly;
         std::array<uint8_t, 16> _buf;
         size_t _bufPos = 0;
     };
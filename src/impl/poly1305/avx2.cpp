@@ -0,0 +1,231 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <dci/utils/dbg.hpp>
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace dci::crypto::impl::poly1305
+{
+    namespace
+    {
+        constexpr std::uint64_t M26 = 0x3ffffff;
+
+        // 44-bit limbs to 26-bit ones, limbs may come slightly above their width
+        inline void to26(std::uint64_t out[5], const std::uint64_t in[3])
+        {
+            out[0] =  (in[0]      ) & M26;
+            out[1] =  (in[0] >> 26) + ((in[1] << 18) & M26);
+            out[2] =  (in[1] >>  8) & M26;
+            out[3] =  (in[1] >> 34) + ((in[2] << 10) & M26);
+            out[4] =  (in[2] >> 16);
+        }
+
+        // 26-bit limbs to 44-bit ones, carrying fully first
+        inline void to44(std::uint64_t out[3], std::uint64_t l[5])
+        {
+            std::uint64_t c;
+                         c = l[0] >> 26; l[0] &= M26;
+            l[1] += c;   c = l[1] >> 26; l[1] &= M26;
+            l[2] += c;   c = l[2] >> 26; l[2] &= M26;
+            l[3] += c;   c = l[3] >> 26; l[3] &= M26;
+            l[4] += c;   c = l[4] >> 26; l[4] &= M26;
+            l[0] += c*5; c = l[0] >> 26; l[0] &= M26;
+            l[1] += c;
+
+            out[0] = (l[0]      ) | ((l[1] << 26) & 0xfffffffffff);
+            out[1] = (l[1] >> 18) + (l[2] << 8) + ((l[3] << 34) & 0xfffffffffff);
+            out[2] = (l[3] >> 10) | (l[4] << 16);
+        }
+
+        inline __m256i mul(__m256i a, __m256i b)
+        {
+            return _mm256_mul_epu32(a, b);
+        }
+
+        inline __m256i add(__m256i a, __m256i b)
+        {
+            return _mm256_add_epi64(a, b);
+        }
+
+        // h = h * r lane-wise, s = 5 * r, result partially reduced
+        inline void mulReduce(__m256i h[5], const __m256i r[5], const __m256i s[5])
+        {
+            __m256i d0 = add(add(add(add(mul(h[0], r[0]), mul(h[1], s[4])), mul(h[2], s[3])), mul(h[3], s[2])), mul(h[4], s[1]));
+            __m256i d1 = add(add(add(add(mul(h[0], r[1]), mul(h[1], r[0])), mul(h[2], s[4])), mul(h[3], s[3])), mul(h[4], s[2]));
+            __m256i d2 = add(add(add(add(mul(h[0], r[2]), mul(h[1], r[1])), mul(h[2], r[0])), mul(h[3], s[4])), mul(h[4], s[3]));
+            __m256i d3 = add(add(add(add(mul(h[0], r[3]), mul(h[1], r[2])), mul(h[2], r[1])), mul(h[3], r[0])), mul(h[4], s[4]));
+            __m256i d4 = add(add(add(add(mul(h[0], r[4]), mul(h[1], r[3])), mul(h[2], r[2])), mul(h[3], r[1])), mul(h[4], r[0]));
+
+            const __m256i m26 = _mm256_set1_epi64x(M26);
+
+            d1 = add(d1, _mm256_srli_epi64(d0, 26)); d0 = _mm256_and_si256(d0, m26);
+            d2 = add(d2, _mm256_srli_epi64(d1, 26)); d1 = _mm256_and_si256(d1, m26);
+            d3 = add(d3, _mm256_srli_epi64(d2, 26)); d2 = _mm256_and_si256(d2, m26);
+            d4 = add(d4, _mm256_srli_epi64(d3, 26)); d3 = _mm256_and_si256(d3, m26);
+
+            const __m256i c = _mm256_srli_epi64(d4, 26); d4 = _mm256_and_si256(d4, m26);
+            d0 = add(d0, add(c, _mm256_slli_epi64(c, 2)));
+            d1 = add(d1, _mm256_srli_epi64(d0, 26)); d0 = _mm256_and_si256(d0, m26);
+
+            h[0] = d0; h[1] = d1; h[2] = d2; h[3] = d3; h[4] = d4;
+        }
+
+        // h += one message block per lane, given as its low and high 64-bit halves
+        inline void absorb(__m256i h[5], __m256i t0, __m256i t1)
+        {
+            const __m256i m26 = _mm256_set1_epi64x(M26);
+            const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+
+            h[0] = add(h[0], _mm256_and_si256(t0, m26));
+            h[1] = add(h[1], _mm256_and_si256(_mm256_srli_epi64(t0, 26), m26));
+            h[2] = add(h[2], _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(t0, 52), _mm256_slli_epi64(t1, 12)), m26));
+            h[3] = add(h[3], _mm256_and_si256(_mm256_srli_epi64(t1, 14), m26));
+            h[4] = add(h[4], _mm256_or_si256(_mm256_srli_epi64(t1, 40), hibit));
+        }
+
+        // h += 4 consecutive message blocks, block j into lane j
+        inline void absorb(__m256i h[5], const std::uint8_t* m)
+        {
+            const __m256i a = _mm256_loadu_si256(static_cast<const __m256i*>(static_cast<const void*>(m +  0)));
+            const __m256i b = _mm256_loadu_si256(static_cast<const __m256i*>(static_cast<const void*>(m + 32)));
+
+            absorb(h,
+                   _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8),
+                   _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xd8));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poly1305_blocks4_avx2(std::uint64_t state[stateSize], const void* m, std::size_t blocks)
+    {
+        dbgAssert(blocks && blocks % 4 == 0);
+
+        powers(state, 4);
+
+        // r^4 in every lane for the loop, r^4..r^1 across the lanes for the last step
+        std::uint64_t r[4][5];
+        for(std::size_t k(0); k<4; ++k)
+        {
+            to26(r[k], power(state, k+1));
+        }
+
+        __m256i rr[5], rs[5], fr[5], fs[5];
+        for(std::size_t i(0); i<5; ++i)
+        {
+            rr[i] = _mm256_set1_epi64x(static_cast<long long>(r[3][i]));
+            rs[i] = add(rr[i], _mm256_slli_epi64(rr[i], 2));
+            fr[i] = _mm256_set_epi64x(static_cast<long long>(r[0][i]), static_cast<long long>(r[1][i]), static_cast<long long>(r[2][i]), static_cast<long long>(r[3][i]));
+            fs[i] = add(fr[i], _mm256_slli_epi64(fr[i], 2));
+        }
+
+        // accumulator goes into lane 0
+        std::uint64_t h26[5];
+        to26(h26, state + 3);
+
+        __m256i h[5];
+        for(std::size_t i(0); i<5; ++i)
+        {
+            h[i] = _mm256_set_epi64x(0, 0, 0, static_cast<long long>(h26[i]));
+        }
+
+        const std::uint8_t* m1 = static_cast<const std::uint8_t*>(m);
+        absorb(h, m1);
+
+        for(std::size_t i(4); i<blocks; i+=4)
+        {
+            mulReduce(h, rr, rs);
+            absorb(h, m1 + i*16);
+        }
+
+        mulReduce(h, fr, fs);
+
+        // sum the lanes and get back to 44-bit limbs
+        std::uint64_t l[5];
+        for(std::size_t i(0); i<5; ++i)
+        {
+            alignas(32) std::uint64_t lanes[4];
+            _mm256_store_si256(static_cast<__m256i*>(static_cast<void*>(lanes)), h[i]);
+            l[i] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+
+        to44(state + 3, l);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poly1305_lanes4_avx2(std::uint64_t* const states[4], const std::uint8_t* const m[4], std::size_t blocks)
+    {
+        static const std::uint8_t idle[16] = {};
+
+        // lane j runs states[j] over m[j], idle lanes spin on a zero block and are not stored
+        alignas(32) std::uint64_t r[5][4], h[5][4], at[4], step[4];
+        for(std::size_t j(0); j<4; ++j)
+        {
+            std::uint64_t r26[5] = {}, h26[5] = {};
+            if(m[j])
+            {
+                to26(r26, states[j]);
+                to26(h26, states[j] + 3);
+            }
+
+            for(std::size_t i(0); i<5; ++i)
+            {
+                r[i][j] = r26[i];
+                h[i][j] = h26[i];
+            }
+
+            at[j] = reinterpret_cast<std::uintptr_t>(m[j] ? m[j] : idle);
+            step[j] = m[j] ? 16 : 0;
+        }
+
+        __m256i vr[5], vs[5], vh[5];
+        for(std::size_t i(0); i<5; ++i)
+        {
+            vr[i] = _mm256_load_si256(static_cast<const __m256i*>(static_cast<const void*>(r[i])));
+            vs[i] = add(vr[i], _mm256_slli_epi64(vr[i], 2));
+            vh[i] = _mm256_load_si256(static_cast<const __m256i*>(static_cast<const void*>(h[i])));
+        }
+
+        const __m256i vstep = _mm256_load_si256(static_cast<const __m256i*>(static_cast<const void*>(step)));
+        __m256i vat = _mm256_load_si256(static_cast<const __m256i*>(static_cast<const void*>(at)));
+
+        for(std::size_t b(0); b<blocks; ++b)
+        {
+            absorb(vh,
+                   _mm256_i64gather_epi64(static_cast<const long long*>(nullptr), vat, 1),
+                   _mm256_i64gather_epi64(static_cast<const long long*>(nullptr), _mm256_add_epi64(vat, _mm256_set1_epi64x(8)), 1));
+
+            mulReduce(vh, vr, vs);
+            vat = add(vat, vstep);
+        }
+
+        for(std::size_t i(0); i<5; ++i)
+        {
+            _mm256_store_si256(static_cast<__m256i*>(static_cast<void*>(h[i])), vh[i]);
+        }
+
+        for(std::size_t j(0); j<4; ++j)
+        {
+            if(m[j])
+            {
+                std::uint64_t l[5] = {h[0][j], h[1][j], h[2][j], h[3][j], h[4][j]};
+                to44(states[j] + 3, l);
+            }
+        }
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
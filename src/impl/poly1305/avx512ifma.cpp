@@ -0,0 +1,214 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <dci/utils/dbg.hpp>
+// _mm512_undefined_* in avx512fintrin.h trips -Wmaybe-uninitialized false positives
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512ifma")
+
+namespace dci::crypto::impl::poly1305
+{
+    namespace
+    {
+        constexpr std::uint64_t M44 = 0xfffffffffff;
+        constexpr std::uint64_t M42 = 0x3ffffffffff;
+
+        // h = h * r lane-wise, s = 20 * r, result partially reduced
+        inline void mulReduce(__m512i h[3], const __m512i r[3], const __m512i s[3])
+        {
+            // 52-bit multiplier splits every product at bit 52: d = lo + hi * 2^52
+            const __m512i zero = _mm512_setzero_si512();
+
+            __m512i lo0 = _mm512_madd52lo_epu64(zero, h[0], r[0]);
+            __m512i hi0 = _mm512_madd52hi_epu64(zero, h[0], r[0]);
+            lo0 = _mm512_madd52lo_epu64(lo0, h[1], s[2]);
+            hi0 = _mm512_madd52hi_epu64(hi0, h[1], s[2]);
+            lo0 = _mm512_madd52lo_epu64(lo0, h[2], s[1]);
+            hi0 = _mm512_madd52hi_epu64(hi0, h[2], s[1]);
+
+            __m512i lo1 = _mm512_madd52lo_epu64(zero, h[0], r[1]);
+            __m512i hi1 = _mm512_madd52hi_epu64(zero, h[0], r[1]);
+            lo1 = _mm512_madd52lo_epu64(lo1, h[1], r[0]);
+            hi1 = _mm512_madd52hi_epu64(hi1, h[1], r[0]);
+            lo1 = _mm512_madd52lo_epu64(lo1, h[2], s[2]);
+            hi1 = _mm512_madd52hi_epu64(hi1, h[2], s[2]);
+
+            __m512i lo2 = _mm512_madd52lo_epu64(zero, h[0], r[2]);
+            __m512i hi2 = _mm512_madd52hi_epu64(zero, h[0], r[2]);
+            lo2 = _mm512_madd52lo_epu64(lo2, h[1], r[1]);
+            hi2 = _mm512_madd52hi_epu64(hi2, h[1], r[1]);
+            lo2 = _mm512_madd52lo_epu64(lo2, h[2], r[0]);
+            hi2 = _mm512_madd52hi_epu64(hi2, h[2], r[0]);
+
+            const __m512i m44 = _mm512_set1_epi64(M44);
+            const __m512i m42 = _mm512_set1_epi64(M42);
+
+            __m512i c;
+            c = _mm512_add_epi64(_mm512_srli_epi64(lo0, 44), _mm512_slli_epi64(hi0, 8));
+            lo1 = _mm512_add_epi64(lo1, c);
+            c = _mm512_add_epi64(_mm512_srli_epi64(lo1, 44), _mm512_slli_epi64(hi1, 8));
+            lo2 = _mm512_add_epi64(lo2, c);
+            c = _mm512_add_epi64(_mm512_srli_epi64(lo2, 42), _mm512_slli_epi64(hi2, 10));
+
+            h[0] = _mm512_add_epi64(_mm512_and_si512(lo0, m44), _mm512_add_epi64(c, _mm512_slli_epi64(c, 2)));
+            h[1] = _mm512_add_epi64(_mm512_and_si512(lo1, m44), _mm512_srli_epi64(h[0], 44));
+            h[0] = _mm512_and_si512(h[0], m44);
+            h[2] = _mm512_and_si512(lo2, m42);
+        }
+
+        // h += one message block per lane, given as its low and high 64-bit halves
+        inline void absorb(__m512i h[3], __m512i t0, __m512i t1)
+        {
+            const __m512i m44 = _mm512_set1_epi64(M44);
+            const __m512i hibit = _mm512_set1_epi64(static_cast<long long>(1) << 40);
+
+            h[0] = _mm512_add_epi64(h[0], _mm512_and_si512(t0, m44));
+            h[1] = _mm512_add_epi64(h[1], _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(t0, 44), _mm512_slli_epi64(t1, 20)), m44));
+            h[2] = _mm512_add_epi64(h[2], _mm512_or_si512(_mm512_srli_epi64(t1, 24), hibit));
+        }
+
+        // h += 8 consecutive message blocks, block j into lane j
+        inline void absorb(__m512i h[3], const std::uint8_t* m)
+        {
+            const __m512i a = _mm512_loadu_si512(m +  0);
+            const __m512i b = _mm512_loadu_si512(m + 64);
+
+            absorb(h,
+                   _mm512_permutex2var_epi64(a, _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), b),
+                   _mm512_permutex2var_epi64(a, _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1), b));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poly1305_blocks8_avx512ifma(std::uint64_t state[stateSize], const void* m, std::size_t blocks)
+    {
+        dbgAssert(blocks && blocks % 8 == 0);
+
+        powers(state, 8);
+
+        // r^8 in every lane for the loop, r^8..r^1 across the lanes for the last step
+        __m512i rr[3], rs[3], fr[3], fs[3];
+        for(std::size_t i(0); i<3; ++i)
+        {
+            long long p[8];
+            for(std::size_t k(0); k<8; ++k)
+            {
+                p[k] = static_cast<long long>(power(state, 8-k)[i]);
+            }
+
+            rr[i] = _mm512_set1_epi64(p[0]);
+            rs[i] = _mm512_add_epi64(_mm512_slli_epi64(rr[i], 4), _mm512_slli_epi64(rr[i], 2));
+            fr[i] = _mm512_loadu_si512(p);
+            fs[i] = _mm512_add_epi64(_mm512_slli_epi64(fr[i], 4), _mm512_slli_epi64(fr[i], 2));
+        }
+
+        // accumulator goes into lane 0
+        __m512i h[3];
+        for(std::size_t i(0); i<3; ++i)
+        {
+            h[i] = _mm512_maskz_set1_epi64(1, static_cast<long long>(state[3+i]));
+        }
+
+        const std::uint8_t* m1 = static_cast<const std::uint8_t*>(m);
+        absorb(h, m1);
+
+        for(std::size_t i(8); i<blocks; i+=8)
+        {
+            mulReduce(h, rr, rs);
+            absorb(h, m1 + i*16);
+        }
+
+        mulReduce(h, fr, fs);
+
+        // sum the lanes and carry back into 44-bit limbs
+        std::uint64_t h0 = static_cast<std::uint64_t>(_mm512_reduce_add_epi64(h[0]));
+        std::uint64_t h1 = static_cast<std::uint64_t>(_mm512_reduce_add_epi64(h[1]));
+        std::uint64_t h2 = static_cast<std::uint64_t>(_mm512_reduce_add_epi64(h[2]));
+
+        std::uint64_t c;
+                     c = h0 >> 44; h0 &= M44;
+        h1 += c;     c = h1 >> 44; h1 &= M44;
+        h2 += c;     c = h2 >> 42; h2 &= M42;
+        h0 += c * 5; c = h0 >> 44; h0 &= M44;
+        h1 += c;
+
+        state[3+0] = h0;
+        state[3+1] = h1;
+        state[3+2] = h2;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poly1305_lanes8_avx512ifma(std::uint64_t* const states[8], const std::uint8_t* const m[8], std::size_t blocks)
+    {
+        static const std::uint8_t idle[16] = {};
+
+        // lane j runs states[j] over m[j], idle lanes spin on a zero block and are not stored
+        alignas(64) std::uint64_t r[3][8], h[3][8], at[8], step[8];
+        for(std::size_t j(0); j<8; ++j)
+        {
+            for(std::size_t i(0); i<3; ++i)
+            {
+                r[i][j] = m[j] ? states[j][i] : 0;
+                h[i][j] = m[j] ? states[j][3+i] : 0;
+            }
+
+            at[j] = reinterpret_cast<std::uintptr_t>(m[j] ? m[j] : idle);
+            step[j] = m[j] ? 16 : 0;
+        }
+
+        __m512i vr[3], vs[3], vh[3];
+        for(std::size_t i(0); i<3; ++i)
+        {
+            vr[i] = _mm512_load_si512(r[i]);
+            vs[i] = _mm512_add_epi64(_mm512_slli_epi64(vr[i], 4), _mm512_slli_epi64(vr[i], 2));
+            vh[i] = _mm512_load_si512(h[i]);
+        }
+
+        const __m512i vstep = _mm512_load_si512(step);
+        __m512i vat = _mm512_load_si512(at);
+
+        for(std::size_t b(0); b<blocks; ++b)
+        {
+            absorb(vh,
+                   _mm512_i64gather_epi64(vat, nullptr, 1),
+                   _mm512_i64gather_epi64(_mm512_add_epi64(vat, _mm512_set1_epi64(8)), nullptr, 1));
+
+            mulReduce(vh, vr, vs);
+            vat = _mm512_add_epi64(vat, vstep);
+        }
+
+        for(std::size_t i(0); i<3; ++i)
+        {
+            _mm512_store_si512(h[i], vh[i]);
+        }
+
+        for(std::size_t j(0); j<8; ++j)
+        {
+            if(m[j])
+            {
+                states[j][3+0] = h[0][j];
+                states[j][3+1] = h[1][j];
+                states[j][3+2] = h[2][j];
+            }
+        }
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
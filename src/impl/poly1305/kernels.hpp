@@ -0,0 +1,46 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dci::crypto::impl::poly1305
+{
+    // state words, all numbers in 44-bit limbs: [0..2] r, [3..5] h, [6..7] pad,
+    // [8] highest power of r computed so far, [9..] r^2, r^3, ... r^maxPower
+    constexpr std::size_t maxPower = 8;
+    constexpr std::size_t stateSize = 9 + 3*(maxPower-1);
+
+    // limbs of r^k, valid for k not above state[8]
+    inline std::uint64_t* power(std::uint64_t state[stateSize], std::size_t k)
+    {
+        return k == 1 ? state : state + 9 + 3*(k-2);
+    }
+
+    // extends the powers of r kept in state up to r^upTo
+    void powers(std::uint64_t state[stateSize], std::size_t upTo);
+
+    // radix 2^64 scalar with mulx and adcx/adox, any blocks, final or not
+    void poly1305_blocks_mulx(std::uint64_t state[stateSize], const void* m, std::size_t blocks, bool is_final);
+
+    // each vector kernel absorbs non-final blocks into h, blocks is a multiple of the kernel width
+
+    // 4 blocks per iteration, one block per 64-bit lane of ymm registers, 26-bit limbs
+    void poly1305_blocks4_avx2(std::uint64_t state[stateSize], const void* m, std::size_t blocks);
+
+    // 8 blocks per iteration, one block per 64-bit lane of zmm registers, 44-bit limbs kept as is
+    void poly1305_blocks8_avx512ifma(std::uint64_t state[stateSize], const void* m, std::size_t blocks);
+
+    // one message per lane: lane j absorbs blocks whole non-final blocks from m[j] into the
+    // accumulator of states[j], lanes with null m are idle and their states are not touched
+    void poly1305_lanes4_avx2(std::uint64_t* const states[4], const std::uint8_t* const m[4], std::size_t blocks);
+    void poly1305_lanes8_avx512ifma(std::uint64_t* const states[8], const std::uint8_t* const m[8], std::size_t blocks);
+}
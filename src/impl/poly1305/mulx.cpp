@@ -0,0 +1,104 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__)
+
+#include "kernels.hpp"
+#include <dci/utils/endian.hpp>
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("bmi2,adx")
+
+namespace dci::crypto::impl::poly1305
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poly1305_blocks_mulx(std::uint64_t state[stateSize], const void* m, std::size_t blocks, bool is_final)
+    {
+        using u64 = unsigned long long;
+
+        const std::uint64_t* m8 = static_cast<const std::uint64_t*>(m);
+
+        const u64 M44 = 0xfffffffffff;
+        const u64 M42 = 0x3ffffffffff;
+
+        const u64 hibit = is_final ? 0 : 1;
+
+        /* r in two 64-bit words, clamping keeps the low 2 bits of r1 clear so s1 = 5 * r1 / 4 */
+        const u64 r0 = state[0] | (state[1] << 44);
+        const u64 r1 = (state[1] >> 20) | (state[2] << 24);
+        const u64 s1 = r1 + (r1 >> 2);
+
+        /* h from 44-bit limbs, h1 may come slightly above its width */
+        const u64 t1 = state[3+1] & M44;
+        const u64 t2 = state[3+2] + (state[3+1] >> 44);
+
+        u64 h0 = state[3+0] | (t1 << 44);
+        u64 h1 = (t1 >> 20) | (t2 << 24);
+        u64 h2 = t2 >> 40;
+
+        for(std::size_t i = 0; i != blocks; ++i)
+        {
+            /* h += m */
+            unsigned char c = _addcarryx_u64(0, h0, dci::utils::endian::n2l(m8[0]), &h0);
+            c = _addcarryx_u64(c, h1, dci::utils::endian::n2l(m8[1]), &h1);
+            h2 += hibit + c;
+
+            /* d0 = h0*r0 + h1*s1, d1 = h0*r1 + h1*r0 + h2*s1 + (d0 >> 64) */
+            u64 a0hi, b0hi, a1hi, b1hi;
+            const u64 a0lo = _mulx_u64(h0, r0, &a0hi);
+            const u64 b0lo = _mulx_u64(h1, s1, &b0hi);
+            const u64 a1lo = _mulx_u64(h0, r1, &a1hi);
+            const u64 b1lo = _mulx_u64(h1, r0, &b1hi);
+
+            u64 d0lo, d0hi, d1lo, d1hi;
+            c = _addcarryx_u64(0, a0lo, b0lo, &d0lo);
+            _addcarryx_u64(c, a0hi, b0hi, &d0hi);
+
+            c = _addcarryx_u64(0, a1lo, b1lo, &d1lo);
+            _addcarryx_u64(c, a1hi, b1hi, &d1hi);
+            c = _addcarryx_u64(0, d1lo, h2 * s1, &d1lo);
+            _addcarryx_u64(c, d1hi, 0, &d1hi);
+            c = _addcarryx_u64(0, d1lo, d0hi, &d1lo);
+            _addcarryx_u64(c, d1hi, 0, &d1hi);
+
+            /* h = d0lo + d1 << 64 + h2*r0 << 128, then fold everything above 2^130 back as *5 */
+            h0 = d0lo;
+            h1 = d1lo;
+            h2 = h2 * r0 + d1hi;
+
+            const u64 f = (h2 >> 2) + (h2 & ~u64{3});
+            h2 &= 3;
+            c = _addcarryx_u64(0, h0, f, &h0);
+            c = _addcarryx_u64(c, h1, 0, &h1);
+            h2 += c;
+
+            m8 += 2;
+        }
+
+        /* back to 44-bit limbs */
+        u64 l0 = h0 & M44;
+        u64 l1 = ((h0 >> 44) | (h1 << 20)) & M44;
+        u64 l2 = (h1 >> 24) | (h2 << 40);
+
+        const u64 f = l2 >> 42;
+        l2 &= M42;
+        l0 += f * 5;
+        l1 += l0 >> 44;
+        l0 &= M44;
+
+        state[3+0] = l0;
+        state[3+1] = l1;
+        state[3+2] = l2;
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
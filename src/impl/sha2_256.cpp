@@ -11,11 +11,36 @@
 #include <type_traits>
 #include <dci/utils/endian.hpp>
 #include <dci/utils/dbg.hpp>
+#include "../cpu/dispatch.hpp"
+#include "sha2_256/kernels.hpp"
 
 namespace dci::crypto::impl
 {
     using namespace dci::utils::endian;
 
+    namespace sha2_256
+    {
+        const std::uint32_t k[64] =
+        {
+            0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL,
+            0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+            0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL,
+            0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+            0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
+            0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+            0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL,
+            0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+            0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL,
+            0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+            0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL,
+            0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+            0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL,
+            0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+            0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
+            0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+        };
+    }
+
     namespace
     {
         static const std::size_t BLOCK_LENGTH           = 64;
@@ -73,25 +98,258 @@ namespace dci::crypto::impl
             0x5be0cd19UL
         };
 
-        const static std::uint32_t K256[64] =
+
+        void sha2_256_transform_generic(std::uint32_t state[8], const void* vdata, std::size_t blocks)
         {
-            0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL,
-            0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
-            0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL,
-            0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
-            0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL,
-            0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
-            0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL,
-            0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
-            0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL,
-            0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
-            0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL,
-            0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
-            0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL,
-            0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
-            0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL,
-            0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+            std::uint32_t a, b, c, d, e, f, g, h, s0, s1;
+            std::uint32_t T1, T2, W256[16];
+
+            const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+
+            for(std::size_t i(0); i<blocks; ++i)
+            {
+                a = state[0];
+                b = state[1];
+                c = state[2];
+                d = state[3];
+                e = state[4];
+                f = state[5];
+                g = state[6];
+                h = state[7];
+
+                int j = 0;
+                do
+                {
+                    memcpy(&W256[j], data, 4);
+                    W256[j] = n2b(W256[j]);
+                    data += 4;
+
+                    T1 = h + Sigma1_256(e) + Ch(e, f, g) + sha2_256::k[j] + W256[j];
+
+                    T2 = Sigma0_256(a) + Maj(a, b, c);
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + T1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = T1 + T2;
+
+                    j++;
+                }
+                while (j < 16);
+
+                do
+                {
+                    s0 = W256[(j+1)&0x0f];
+                    s0 = sigma0_256(s0);
+                    s1 = W256[(j+14)&0x0f];
+                    s1 = sigma1_256(s1);
+
+                    T1 = h + Sigma1_256(e) + Ch(e, f, g) + sha2_256::k[j] + (W256[j&0x0f] += s1 + W256[(j+9)&0x0f] + s0);
+                    T2 = Sigma0_256(a) + Maj(a, b, c);
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + T1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = T1 + T2;
+
+                    j++;
+                }
+                while (j < 64);
+
+                state[0] += a;
+                state[1] += b;
+                state[2] += c;
+                state[3] += d;
+                state[4] += e;
+                state[5] += f;
+                state[6] += g;
+                state[7] += h;
+            }
+        }
+
+        using Transform = void (*)(std::uint32_t state[8], const void* data, std::size_t blocks);
+
+        Transform transformImpl = &sha2_256_transform_generic;
+
+        std::string_view transformBind()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if(cpu::use(cpu::Tier::ssse3, cpu::ssse3 | cpu::sse41 | cpu::sha))
+            {
+                transformImpl = &sha2_256::sha2_256_transform_shani;
+                return "shani";
+            }
+
+            if(cpu::use(cpu::Tier::avx2, cpu::avx2 | cpu::bmi2))
+            {
+                transformImpl = &sha2_256::sha2_256_transform_avx2;
+                return "avx2";
+            }
+#endif
+
+            transformImpl = &sha2_256_transform_generic;
+            return "generic";
+        }
+
+        const cpu::Binder transformBinder {"sha2_256", &transformBind};
+
+        // one block per lane, word k of lane j at states[lanes*k + j]
+        struct Lanes
+        {
+            void (*compress)(std::uint32_t* states, const std::uint8_t* const* data);
+            std::size_t lanes;
         };
+
+        void sha2_256_lanes1(std::uint32_t* states, const std::uint8_t* const* data)
+        {
+            transformImpl(states, data[0], 1);
+        }
+
+        Lanes lanesImpl {&sha2_256_lanes1, 1};
+
+        std::string_view lanesBind()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if(cpu::use(cpu::Tier::avx512, cpu::avx512f))
+            {
+                lanesImpl = {&sha2_256::sha2_256_lanes16_avx512, 16};
+                return "avx512";
+            }
+
+            // sha-ni on one message outruns 8 avx2 lanes
+            if(cpu::use(cpu::Tier::avx2, cpu::avx2 | cpu::bmi2) && !cpu::use(cpu::Tier::ssse3, cpu::ssse3 | cpu::sse41 | cpu::sha))
+            {
+                lanesImpl = {&sha2_256::sha2_256_lanes8_avx2, 8};
+                return "avx2";
+            }
+#endif
+
+            lanesImpl = {&sha2_256_lanes1, 1};
+            return "single";
+        }
+
+        const cpu::Binder lanesBinder {"sha2_256.lanes", &lanesBind};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Sha2_256::hashBatch(const Sha2_256Job* jobs, std::size_t count)
+    {
+        static constexpr std::size_t maxLanes = 16;
+        static const std::array<std::uint8_t, BLOCK_LENGTH> idle {};
+
+        struct Lane
+        {
+            const Sha2_256Job*                      _job;
+            const std::uint8_t*                     _data;
+            std::size_t                             _blocks;    // whole blocks left in _data
+            std::size_t                             _tailBlocks;
+            std::size_t                             _tailDone;
+            std::array<std::uint8_t, 2*BLOCK_LENGTH> _tail;     // padded last one or two blocks
+        };
+
+        const Lanes impl = lanesImpl;
+        dbgAssert(impl.lanes <= maxLanes);
+
+        std::array<std::uint32_t, 8*maxLanes> states;
+        std::array<const std::uint8_t*, maxLanes> data;
+        std::array<Lane, maxLanes> lanes {};
+
+        std::size_t next = 0;
+        auto feed = [&](std::size_t lane)
+        {
+            if(next == count)
+            {
+                lanes[lane]._job = nullptr;
+                return false;
+            }
+
+            const Sha2_256Job& job = jobs[next++];
+            dbgAssert(job.digestSize >= 1 && job.digestSize <= 32);
+
+            Lane& l = lanes[lane];
+            l._job = &job;
+            l._data = static_cast<const std::uint8_t*>(job.data);
+            l._blocks = job.len / BLOCK_LENGTH;
+
+            const std::size_t rest = job.len % BLOCK_LENGTH;
+            l._tailBlocks = rest < SHORT_BLOCK_LENGTH ? 1 : 2;
+            l._tailDone = 0;
+
+            const std::size_t tailSize = l._tailBlocks * BLOCK_LENGTH;
+            if(rest)
+            {
+                memcpy(l._tail.data(), l._data + l._blocks * BLOCK_LENGTH, rest);
+            }
+            l._tail[rest] = 0x80;
+            memset(&l._tail[rest+1], 0, tailSize - 8 - rest - 1);
+
+            const std::uint64_t bitcount = n2b(std::uint64_t{job.len} << 3);
+            memcpy(&l._tail[tailSize - 8], &bitcount, 8);
+
+            for(std::size_t k(0); k<8; ++k)
+            {
+                states[impl.lanes*k + lane] = IV[k];
+            }
+
+            return true;
+        };
+
+        std::size_t active = 0;
+        for(std::size_t lane(0); lane<impl.lanes; ++lane)
+        {
+            active += feed(lane) ? 1 : 0;
+        }
+
+        // one block per lane per step, a finished lane takes the next job
+        while(active)
+        {
+            for(std::size_t lane(0); lane<impl.lanes; ++lane)
+            {
+                const Lane& l = lanes[lane];
+                data[lane] = !l._job ? idle.data() : l._blocks ? l._data : l._tail.data() + l._tailDone * BLOCK_LENGTH;
+            }
+
+            impl.compress(states.data(), data.data());
+
+            for(std::size_t lane(0); lane<impl.lanes; ++lane)
+            {
+                Lane& l = lanes[lane];
+                if(!l._job)
+                {
+                    continue;
+                }
+
+                if(l._blocks)
+                {
+                    l._blocks--;
+                    l._data += BLOCK_LENGTH;
+                    continue;
+                }
+
+                if(++l._tailDone < l._tailBlocks)
+                {
+                    continue;
+                }
+
+                std::array<std::uint32_t, 8> digest;
+                for(std::size_t k(0); k<8; ++k)
+                {
+                    digest[k] = n2b(states[impl.lanes*k + lane]);
+                }
+                memcpy(l._job->digest, digest.data(), std::min(l._job->digestSize, std::size_t{32}));
+
+                if(!feed(lane))
+                {
+                    active--;
+                }
+            }
+        }
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -195,7 +453,7 @@ namespace dci::crypto::impl
                 _bitcount += freespace << 3;
                 len -= freespace;
                 data += freespace;
-                transform(_buffer.data());
+                transform(_buffer.data(), 1);
             }
             else
             {
@@ -204,12 +462,13 @@ namespace dci::crypto::impl
                 return;
             }
         }
-        while (len >= BLOCK_LENGTH)
+        if(len >= BLOCK_LENGTH)
         {
-            transform(data);
-            _bitcount += BLOCK_LENGTH << 3;
-            len -= BLOCK_LENGTH;
-            data += BLOCK_LENGTH;
+            const std::size_t blocks = len / BLOCK_LENGTH;
+            transform(data, blocks);
+            _bitcount += (blocks * BLOCK_LENGTH) << 3;
+            len -= blocks * BLOCK_LENGTH;
+            data += blocks * BLOCK_LENGTH;
         }
         if(len > 0)
         {
@@ -259,7 +518,7 @@ namespace dci::crypto::impl
                 {
                     memset(&_buffer[usedspace], 0, BLOCK_LENGTH - usedspace);
                 }
-                transform(_buffer.data());
+                transform(_buffer.data(), 1);
 
                 memset(_buffer.data(), 0, SHORT_BLOCK_LENGTH);
             }
@@ -274,7 +533,7 @@ namespace dci::crypto::impl
         void* bcPtr = &_buffer[SHORT_BLOCK_LENGTH];
         *static_cast<std::uint64_t*>(bcPtr) = _bitcount;
 
-        transform(_buffer.data());
+        transform(_buffer.data(), 1);
 
         if constexpr(std::endian::big != std::endian::native)
         {
@@ -297,78 +556,8 @@ namespace dci::crypto::impl
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void Sha2_256::transform(const void* data)
-    {
-        return transform(static_cast<const std::uint32_t*>(data));
-    }
-
-    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void Sha2_256::transform(const std::uint32_t* data)
+    void Sha2_256::transform(const void* data, std::size_t blocks)
     {
-        std::uint32_t a, b, c, d, e, f, g, h, s0, s1;
-        std::uint32_t T1, T2, *W256;
-
-        W256 = static_cast<std::uint32_t*>(static_cast<void*>(_buffer.data()));
-
-        a = _state[0];
-        b = _state[1];
-        c = _state[2];
-        d = _state[3];
-        e = _state[4];
-        f = _state[5];
-        g = _state[6];
-        h = _state[7];
-
-        int j = 0;
-        do
-        {
-            W256[j] = n2b(*data++);
-
-            T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + W256[j];
-
-            T2 = Sigma0_256(a) + Maj(a, b, c);
-            h = g;
-            g = f;
-            f = e;
-            e = d + T1;
-            d = c;
-            c = b;
-            b = a;
-            a = T1 + T2;
-
-            j++;
-        }
-        while (j < 16);
-
-        do
-        {
-            s0 = W256[(j+1)&0x0f];
-            s0 = sigma0_256(s0);
-            s1 = W256[(j+14)&0x0f];
-            s1 = sigma1_256(s1);
-
-            T1 = h + Sigma1_256(e) + Ch(e, f, g) + K256[j] + (W256[j&0x0f] += s1 + W256[(j+9)&0x0f] + s0);
-            T2 = Sigma0_256(a) + Maj(a, b, c);
-            h = g;
-            g = f;
-            f = e;
-            e = d + T1;
-            d = c;
-            c = b;
-            b = a;
-            a = T1 + T2;
-
-            j++;
-        }
-        while (j < 64);
-
-        _state[0] += a;
-        _state[1] += b;
-        _state[2] += c;
-        _state[3] += d;
-        _state[4] += e;
-        _state[5] += f;
-        _state[6] += g;
-        _state[7] += h;
+        transformImpl(_state.data(), data, blocks);
     }
 }
@@ -10,12 +10,16 @@
 #include <cstdint>
 #include "hash.hpp"
 #include <array>
+#include <dci/crypto/sha2_256Job.hpp>
 
 namespace dci::crypto::impl
 {
     class Sha2_256 final
         : public Hash
     {
+    public:
+        static void hashBatch(const Sha2_256Job* jobs, std::size_t count);
+
     public:
         Sha2_256(std::size_t digestSize);
         Sha2_256(const Sha2_256&);
@@ -35,8 +39,7 @@ namespace dci::crypto::impl
         void clear() override;
 
     private:
-        void transform(const void* data);
-        void transform(const std::uint32_t* data);
+        void transform(const void* data, std::size_t blocks);
 
         std::array<std::uint32_t, 8>    _state;
         std::uint64_t                   _bitcount;
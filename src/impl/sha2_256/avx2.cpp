@@ -0,0 +1,211 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include "rounds.hpp"
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2,bmi2")
+
+namespace dci::crypto::impl::sha2_256
+{
+    namespace
+    {
+        inline __m256i load(const void* p)
+        {
+            return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+        }
+
+        inline void store(void* p, __m256i v)
+        {
+            _mm256_storeu_si256(static_cast<__m256i*>(p), v);
+        }
+
+        template <int ROT>
+        inline __m256i rotr(__m256i v)
+        {
+            return _mm256_or_si256(_mm256_srli_epi32(v, ROT), _mm256_slli_epi32(v, 32-ROT));
+        }
+
+        inline __m256i xor3(__m256i a, __m256i b, __m256i c)
+        {
+            return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+        }
+
+        inline __m256i add3(__m256i a, __m256i b, __m256i c)
+        {
+            return _mm256_add_epi32(_mm256_add_epi32(a, b), c);
+        }
+
+        inline __m128i load128(const void* p)
+        {
+            return _mm_loadu_si128(static_cast<const __m128i*>(p));
+        }
+
+        inline __m256i sigma0(__m256i v)
+        {
+            return xor3(rotr<7>(v), rotr<18>(v), _mm256_srli_epi32(v, 3));
+        }
+
+        inline __m256i sigma1(__m256i v)
+        {
+            return xor3(rotr<17>(v), rotr<19>(v), _mm256_srli_epi32(v, 10));
+        }
+
+        // w[t..t+3] from w0 = w[t-16..t-13] .. w3 = w[t-4..t-1] in each 128-bit half; sigma1 of
+        // w[t-2] and w[t-1] gives the low pair, the high pair needs the low one first
+        inline __m256i next(__m256i w0, __m256i w1, __m256i w2, __m256i w3)
+        {
+            const __m256i x = add3(w0, sigma0(_mm256_alignr_epi8(w1, w0, 4)), _mm256_alignr_epi8(w3, w2, 4));
+            const __m256i lo = _mm256_add_epi32(x, sigma1(_mm256_shuffle_epi32(w3, 0xee)));
+            const __m256i hi = _mm256_add_epi32(x, sigma1(_mm256_shuffle_epi32(lo, 0x44)));
+            return _mm256_unpacklo_epi64(lo, _mm256_unpackhi_epi64(hi, hi));
+        }
+
+        inline void storeWk(std::uint32_t wk[2][64], std::size_t g, __m256i v)
+        {
+            _mm_store_si128(static_cast<__m128i*>(static_cast<void*>(wk[0] + 4*g)), _mm256_castsi256_si128(v));
+            _mm_store_si128(static_cast<__m128i*>(static_cast<void*>(wk[1] + 4*g)), _mm256_extracti128_si256(v, 1));
+        }
+
+        // words 8*half .. 8*half+7 of all 8 blocks, w[t] holds word t of every lane
+        inline void loadTransposed(__m256i w[8], const std::uint8_t* const data[8], std::size_t half)
+        {
+            const __m256i bswap = _mm256_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll, 0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+
+            __m256i r[8], t[8];
+            #pragma GCC unroll 8
+            for(std::size_t j(0); j<8; ++j)
+            {
+                r[j] = load(data[j] + 32*half);
+            }
+
+            #pragma GCC unroll 4
+            for(std::size_t i(0); i<4; ++i)
+            {
+                t[2*i+0] = _mm256_unpacklo_epi32(r[2*i], r[2*i+1]);
+                t[2*i+1] = _mm256_unpackhi_epi32(r[2*i], r[2*i+1]);
+            }
+
+            #pragma GCC unroll 2
+            for(std::size_t i(0); i<2; ++i)
+            {
+                r[4*i+0] = _mm256_unpacklo_epi64(t[4*i+0], t[4*i+2]);
+                r[4*i+1] = _mm256_unpackhi_epi64(t[4*i+0], t[4*i+2]);
+                r[4*i+2] = _mm256_unpacklo_epi64(t[4*i+1], t[4*i+3]);
+                r[4*i+3] = _mm256_unpackhi_epi64(t[4*i+1], t[4*i+3]);
+            }
+
+            #pragma GCC unroll 4
+            for(std::size_t k(0); k<4; ++k)
+            {
+                w[k+0] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r[k], r[4+k], 0x20), bswap);
+                w[k+4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r[k], r[4+k], 0x31), bswap);
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sha2_256_transform_avx2(std::uint32_t state[8], const void* vdata, std::size_t blocks)
+    {
+        const __m256i bswap = _mm256_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll, 0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+        const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+
+        alignas(32) std::uint32_t wk[2][64];
+
+        while(blocks)
+        {
+            // a lone last block goes to both halves, the high one is then ignored
+            const std::uint8_t* second = blocks > 1 ? data + 64 : data;
+
+            __m256i w[4];
+            #pragma GCC unroll 4
+            for(std::size_t g(0); g<4; ++g)
+            {
+                w[g] = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(load128(data + 16*g)), load128(second + 16*g), 1), bswap);
+                storeWk(wk, g, _mm256_add_epi32(w[g], _mm256_broadcastsi128_si256(load128(k + 4*g))));
+            }
+
+            #pragma GCC unroll 12
+            for(std::size_t g(4); g<16; ++g)
+            {
+                w[g&3] = next(w[g&3], w[(g+1)&3], w[(g+2)&3], w[(g+3)&3]);
+                storeWk(wk, g, _mm256_add_epi32(w[g&3], _mm256_broadcastsi128_si256(load128(k + 4*g))));
+            }
+
+            rounds(state, wk[0]);
+            if(blocks == 1)
+            {
+                break;
+            }
+
+            rounds(state, wk[1]);
+            blocks -= 2;
+            data += 128;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sha2_256_lanes8_avx2(std::uint32_t states[8*8], const std::uint8_t* const data[8])
+    {
+        __m256i w[16];
+        loadTransposed(w+0, data, 0);
+        loadTransposed(w+8, data, 1);
+
+        __m256i s[8];
+        #pragma GCC unroll 8
+        for(std::size_t k(0); k<8; ++k)
+        {
+            s[k] = load(states + 8*k);
+        }
+
+        __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+        #pragma GCC unroll 64
+        for(std::size_t t(0); t<64; ++t)
+        {
+            if(t >= 16)
+            {
+                const __m256i w15 = w[(t+1)&15];
+                const __m256i w2 = w[(t+14)&15];
+                const __m256i s0 = xor3(rotr<7>(w15), rotr<18>(w15), _mm256_srli_epi32(w15, 3));
+                const __m256i s1 = xor3(rotr<17>(w2), rotr<19>(w2), _mm256_srli_epi32(w2, 10));
+                w[t&15] = _mm256_add_epi32(add3(w[t&15], s0, w[(t+9)&15]), s1);
+            }
+
+            const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i t1 = _mm256_add_epi32(
+                                   add3(h, xor3(rotr<6>(e), rotr<11>(e), rotr<25>(e)), ch),
+                                   _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(k[t])), w[t&15]));
+            const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            const __m256i t2 = _mm256_add_epi32(xor3(rotr<2>(a), rotr<13>(a), rotr<22>(a)), maj);
+
+            h = g; g = f; f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c; c = b; b = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+
+        store(states + 8*0, _mm256_add_epi32(s[0], a));
+        store(states + 8*1, _mm256_add_epi32(s[1], b));
+        store(states + 8*2, _mm256_add_epi32(s[2], c));
+        store(states + 8*3, _mm256_add_epi32(s[3], d));
+        store(states + 8*4, _mm256_add_epi32(s[4], e));
+        store(states + 8*5, _mm256_add_epi32(s[5], f));
+        store(states + 8*6, _mm256_add_epi32(s[6], g));
+        store(states + 8*7, _mm256_add_epi32(s[7], h));
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,151 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+// _mm512_undefined_* in avx512fintrin.h trips -Wmaybe-uninitialized false positives
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+namespace dci::crypto::impl::sha2_256
+{
+    namespace
+    {
+        inline __m512i load(const void* p)
+        {
+            return _mm512_loadu_si512(p);
+        }
+
+        inline void store(void* p, __m512i v)
+        {
+            _mm512_storeu_si512(p, v);
+        }
+
+        inline __m512i xor3(__m512i a, __m512i b, __m512i c)
+        {
+            return _mm512_ternarylogic_epi32(a, b, c, 0x96);
+        }
+
+        inline __m512i add3(__m512i a, __m512i b, __m512i c)
+        {
+            return _mm512_add_epi32(_mm512_add_epi32(a, b), c);
+        }
+
+        inline __m512i bswap(__m512i v)
+        {
+            // no vpshufb in avx512f, rotate halves then bytes within halves
+            v = _mm512_or_si512(_mm512_slli_epi32(v, 16), _mm512_srli_epi32(v, 16));
+            const __m512i lo = _mm512_set1_epi32(0x00ff00ff);
+            return _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(v, lo), 8), _mm512_and_si512(_mm512_srli_epi32(v, 8), lo));
+        }
+
+        // all 16 words of all 16 blocks, w[t] holds word t of every lane
+        inline void loadTransposed(__m512i w[16], const std::uint8_t* const data[16])
+        {
+            __m512i r[16], t[16];
+            #pragma GCC unroll 16
+            for(std::size_t j(0); j<16; ++j)
+            {
+                r[j] = load(data[j]);
+            }
+
+            #pragma GCC unroll 8
+            for(std::size_t i(0); i<8; ++i)
+            {
+                t[2*i+0] = _mm512_unpacklo_epi32(r[2*i], r[2*i+1]);
+                t[2*i+1] = _mm512_unpackhi_epi32(r[2*i], r[2*i+1]);
+            }
+
+            // 128-bit lane l of r[4*i+k] is word 4*l+k of blocks 4*i .. 4*i+3
+            #pragma GCC unroll 4
+            for(std::size_t i(0); i<4; ++i)
+            {
+                r[4*i+0] = _mm512_unpacklo_epi64(t[4*i+0], t[4*i+2]);
+                r[4*i+1] = _mm512_unpackhi_epi64(t[4*i+0], t[4*i+2]);
+                r[4*i+2] = _mm512_unpacklo_epi64(t[4*i+1], t[4*i+3]);
+                r[4*i+3] = _mm512_unpackhi_epi64(t[4*i+1], t[4*i+3]);
+            }
+
+            #pragma GCC unroll 4
+            for(std::size_t k(0); k<4; ++k)
+            {
+                const __m512i p01 = _mm512_shuffle_i32x4(r[k+0], r[k+4], 0x44);
+                const __m512i p23 = _mm512_shuffle_i32x4(r[k+0], r[k+4], 0xee);
+                const __m512i q01 = _mm512_shuffle_i32x4(r[k+8], r[k+12], 0x44);
+                const __m512i q23 = _mm512_shuffle_i32x4(r[k+8], r[k+12], 0xee);
+
+                w[k+ 0] = bswap(_mm512_shuffle_i32x4(p01, q01, 0x88));
+                w[k+ 4] = bswap(_mm512_shuffle_i32x4(p01, q01, 0xdd));
+                w[k+ 8] = bswap(_mm512_shuffle_i32x4(p23, q23, 0x88));
+                w[k+12] = bswap(_mm512_shuffle_i32x4(p23, q23, 0xdd));
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sha2_256_lanes16_avx512(std::uint32_t states[8*16], const std::uint8_t* const data[16])
+    {
+        __m512i w[16];
+        loadTransposed(w, data);
+
+        __m512i s[8];
+        #pragma GCC unroll 8
+        for(std::size_t j(0); j<8; ++j)
+        {
+            s[j] = load(states + 16*j);
+        }
+
+        __m512i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+        #pragma GCC unroll 64
+        for(std::size_t t(0); t<64; ++t)
+        {
+            if(t >= 16)
+            {
+                const __m512i w15 = w[(t+1)&15];
+                const __m512i w2 = w[(t+14)&15];
+                const __m512i s0 = xor3(_mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18), _mm512_srli_epi32(w15, 3));
+                const __m512i s1 = xor3(_mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19), _mm512_srli_epi32(w2, 10));
+                w[t&15] = _mm512_add_epi32(add3(w[t&15], s0, w[(t+9)&15]), s1);
+            }
+
+            const __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xca);
+            const __m512i t1 = _mm512_add_epi32(
+                                   add3(h, xor3(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25)), ch),
+                                   _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(k[t])), w[t&15]));
+            const __m512i maj = _mm512_ternarylogic_epi32(a, b, c, 0xe8);
+            const __m512i t2 = _mm512_add_epi32(xor3(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22)), maj);
+
+            h = g; g = f; f = e;
+            e = _mm512_add_epi32(d, t1);
+            d = c; c = b; b = a;
+            a = _mm512_add_epi32(t1, t2);
+        }
+
+        store(states + 16*0, _mm512_add_epi32(s[0], a));
+        store(states + 16*1, _mm512_add_epi32(s[1], b));
+        store(states + 16*2, _mm512_add_epi32(s[2], c));
+        store(states + 16*3, _mm512_add_epi32(s[3], d));
+        store(states + 16*4, _mm512_add_epi32(s[4], e));
+        store(states + 16*5, _mm512_add_epi32(s[5], f));
+        store(states + 16*6, _mm512_add_epi32(s[6], g));
+        store(states + 16*7, _mm512_add_epi32(s[7], h));
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -0,0 +1,29 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dci::crypto::impl::sha2_256
+{
+    // round constants, fips 180-4 section 4.2.2
+    extern const std::uint32_t k[64];
+
+    // state = compression of each of blocks consecutive 64-byte blocks of data, in order
+    void sha2_256_transform_shani(std::uint32_t state[8], const void* data, std::size_t blocks);
+
+    // scalar rounds, message schedule for two blocks at once in ymm registers, one per 128-bit half
+    void sha2_256_transform_avx2(std::uint32_t state[8], const void* data, std::size_t blocks);
+
+    // one block for each of N independent states, word k of state j lives at states[N*k + j] and
+    // its 64-byte block at data[j]
+    void sha2_256_lanes8_avx2(std::uint32_t states[8*8], const std::uint8_t* const data[8]);
+    void sha2_256_lanes16_avx512(std::uint32_t states[8*16], const std::uint8_t* const data[16]);
+}
@@ -0,0 +1,53 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// scalar rounds over a precomputed schedule, included by each kernel translation unit so it is
+// compiled for that unit's target
+namespace dci::crypto::impl::sha2_256
+{
+    namespace
+    {
+        template <int ROT>
+        inline std::uint32_t ror(std::uint32_t x)
+        {
+            return (x >> ROT) | (x << (32 - ROT));
+        }
+
+        // state = compression of one block given its wk[t] = w[t] + k[t]
+        inline void rounds(std::uint32_t state[8], const std::uint32_t wk[64])
+        {
+            std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+            // maj(a, b, c) = b ^ ((a ^ b) & (b ^ c)), and a ^ b is the next round's b ^ c
+            std::uint32_t bc = b ^ c;
+
+            #pragma GCC unroll 16
+            for(std::size_t t(0); t<64; ++t)
+            {
+                const std::uint32_t t1 = h + ror<6>(e ^ ror<5>(e ^ ror<14>(e))) + (g ^ (e & (f ^ g))) + wk[t];
+                const std::uint32_t ab = a ^ b;
+                const std::uint32_t t2 = ror<2>(a ^ ror<11>(a ^ ror<9>(a))) + (b ^ (ab & bc));
+                bc = ab;
+
+                h = g; g = f; f = e;
+                e = d + t1;
+                d = c; c = b; b = a;
+                a = t1 + t2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    }
+}
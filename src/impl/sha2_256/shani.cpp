@@ -0,0 +1,86 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("ssse3,sse4.1,sha")
+
+namespace dci::crypto::impl::sha2_256
+{
+    namespace
+    {
+        inline __m128i load(const void* p)
+        {
+            return _mm_loadu_si128(static_cast<const __m128i*>(p));
+        }
+
+        inline void store(void* p, __m128i v)
+        {
+            _mm_storeu_si128(static_cast<__m128i*>(p), v);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sha2_256_transform_shani(std::uint32_t state[8], const void* vdata, std::size_t blocks)
+    {
+        const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll);
+        const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+
+        // sha256rnds2 wants the state as ABEF and CDGH
+        __m128i tmp = _mm_shuffle_epi32(load(state + 0), 0xb1);
+        __m128i cdgh = _mm_shuffle_epi32(load(state + 4), 0x1b);
+        __m128i abef = _mm_alignr_epi8(tmp, cdgh, 8);
+        cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+        for(; blocks; --blocks, data += 64)
+        {
+            const __m128i abefSave = abef;
+            const __m128i cdghSave = cdgh;
+
+            // m[g&3] holds schedule words 4g..4g+3
+            __m128i m[4];
+            #pragma GCC unroll 4
+            for(std::size_t g(0); g<4; ++g)
+            {
+                m[g] = _mm_shuffle_epi8(load(data + 16*g), bswap);
+            }
+
+            #pragma GCC unroll 16
+            for(std::size_t g(0); g<16; ++g)
+            {
+                if(g >= 4)
+                {
+                    const __m128i w7 = _mm_alignr_epi8(m[(g+3)&3], m[(g+2)&3], 4);
+                    m[g&3] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m[g&3], m[(g+1)&3]), w7), m[(g+3)&3]);
+                }
+
+                __m128i wk = _mm_add_epi32(m[g&3], load(k + 4*g));
+                cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+                wk = _mm_shuffle_epi32(wk, 0x0e);
+                abef = _mm_sha256rnds2_epu32(abef, cdgh, wk);
+            }
+
+            abef = _mm_add_epi32(abef, abefSave);
+            cdgh = _mm_add_epi32(cdgh, cdghSave);
+        }
+
+        tmp = _mm_shuffle_epi32(abef, 0x1b);
+        cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+        store(state + 0, _mm_blend_epi16(tmp, cdgh, 0xf0));
+        store(state + 4, _mm_alignr_epi8(cdgh, tmp, 8));
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
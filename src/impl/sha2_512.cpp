@@ -11,15 +11,40 @@
 #include <type_traits>
 #include <dci/utils/endian.hpp>
 #include <dci/utils/dbg.hpp>
+#include "../cpu/dispatch.hpp"
+#include "sha2_512/kernels.hpp"
 
 namespace dci::crypto::impl
 {
     using namespace dci::utils::endian;
 
+    namespace sha2_512
+    {
+        const std::uint64_t k[80] =
+        {
+            0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL,
+            0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+            0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL, 0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+            0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+            0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL, 0x983e5152ee66dfabULL,
+            0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+            0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL,
+            0x53380d139d95b3dfULL, 0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+            0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+            0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL, 0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+            0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL,
+            0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+            0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL, 0xca273eceea26619cULL,
+            0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+            0x113f9804bef90daeULL, 0x1b710b35131c471bULL, 0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+            0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+        };
+    }
+
     namespace
     {
         static const std::size_t BLOCK_LENGTH           = 128;
-        static const std::size_t SHORT_BLOCK_LENGTH     = (BLOCK_LENGTH - 8);
+        static const std::size_t SHORT_BLOCK_LENGTH     = (BLOCK_LENGTH - 16);
 
         inline std::uint64_t R(std::uint64_t  b, std::uint64_t x)
         {
@@ -73,25 +98,106 @@ namespace dci::crypto::impl
             0x5be0cd19137e2179ULL
         };
 
-        const static std::uint64_t K512[80] =
+
+        void sha2_512_transform_generic(std::uint64_t state[8], const void* vdata, std::size_t blocks)
         {
-            0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL,
-            0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
-            0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL, 0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
-            0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
-            0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL, 0x983e5152ee66dfabULL,
-            0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
-            0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL,
-            0x53380d139d95b3dfULL, 0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
-            0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
-            0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL, 0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
-            0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL,
-            0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
-            0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL, 0xca273eceea26619cULL,
-            0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
-            0x113f9804bef90daeULL, 0x1b710b35131c471bULL, 0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
-            0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
-        };
+            std::uint64_t a, b, c, d, e, f, g, h, s0, s1;
+            std::uint64_t T1, T2, W512[16];
+
+            const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+
+            for(std::size_t i(0); i<blocks; ++i)
+            {
+                a = state[0];
+                b = state[1];
+                c = state[2];
+                d = state[3];
+                e = state[4];
+                f = state[5];
+                g = state[6];
+                h = state[7];
+
+                int j = 0;
+                do
+                {
+                    memcpy(&W512[j], data, 8);
+                    W512[j] = n2b(W512[j]);
+                    data += 8;
+
+                    T1 = h + Sigma1_512(e) + Ch(e, f, g) + sha2_512::k[j] + W512[j];
+
+                    T2 = Sigma0_512(a) + Maj(a, b, c);
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + T1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = T1 + T2;
+
+                    j++;
+                }
+                while (j < 16);
+
+                do
+                {
+                    s0 = W512[(j+1)&0x0f];
+                    s0 = sigma0_512(s0);
+                    s1 = W512[(j+14)&0x0f];
+                    s1 = sigma1_512(s1);
+
+                    T1 = h + Sigma1_512(e) + Ch(e, f, g) + sha2_512::k[j] + (W512[j&0x0f] += s1 + W512[(j+9)&0x0f] + s0);
+                    T2 = Sigma0_512(a) + Maj(a, b, c);
+                    h = g;
+                    g = f;
+                    f = e;
+                    e = d + T1;
+                    d = c;
+                    c = b;
+                    b = a;
+                    a = T1 + T2;
+
+                    j++;
+                }
+                while (j < 80);
+
+                state[0] += a;
+                state[1] += b;
+                state[2] += c;
+                state[3] += d;
+                state[4] += e;
+                state[5] += f;
+                state[6] += g;
+                state[7] += h;
+            }
+        }
+
+        using Transform = void (*)(std::uint64_t state[8], const void* data, std::size_t blocks);
+
+        Transform transformImpl = &sha2_512_transform_generic;
+
+        std::string_view transformBind()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if(cpu::use(cpu::Tier::avx2, cpu::avx2 | cpu::bmi2))
+            {
+                transformImpl = &sha2_512::sha2_512_transform_avx2;
+                return "avx2";
+            }
+
+            if(cpu::use(cpu::Tier::ssse3, cpu::ssse3))
+            {
+                transformImpl = &sha2_512::sha2_512_transform_ssse3;
+                return "ssse3";
+            }
+#endif
+
+            transformImpl = &sha2_512_transform_generic;
+            return "generic";
+        }
+
+        const cpu::Binder transformBinder {"sha2_512", &transformBind};
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -195,7 +301,7 @@ namespace dci::crypto::impl
                 _bitcount += freespace << 3;
                 len -= freespace;
                 data += freespace;
-                transform(_buffer.data());
+                transform(_buffer.data(), 1);
             }
             else
             {
@@ -204,12 +310,13 @@ namespace dci::crypto::impl
                 return;
             }
         }
-        while (len >= BLOCK_LENGTH)
+        if(len >= BLOCK_LENGTH)
         {
-            transform(data);
-            _bitcount += BLOCK_LENGTH << 3;
-            len -= BLOCK_LENGTH;
-            data += BLOCK_LENGTH;
+            const std::size_t blocks = len / BLOCK_LENGTH;
+            transform(data, blocks);
+            _bitcount += (blocks * BLOCK_LENGTH) << 3;
+            len -= blocks * BLOCK_LENGTH;
+            data += blocks * BLOCK_LENGTH;
         }
         if(len > 0)
         {
@@ -259,7 +366,7 @@ namespace dci::crypto::impl
                 {
                     memset(&_buffer[usedspace], 0, BLOCK_LENGTH - usedspace);
                 }
-                transform(_buffer.data());
+                transform(_buffer.data(), 1);
 
                 memset(_buffer.data(), 0, SHORT_BLOCK_LENGTH);
             }
@@ -271,10 +378,12 @@ namespace dci::crypto::impl
             _buffer[0] = 0x80;
         }
 
-        void* bcPtr = &_buffer[SHORT_BLOCK_LENGTH];
+        // 128-bit big endian length, the high half is always zero here
+        memset(&_buffer[SHORT_BLOCK_LENGTH], 0, 8);
+        void* bcPtr = &_buffer[SHORT_BLOCK_LENGTH + 8];
         *static_cast<std::uint64_t*>(bcPtr) = _bitcount;
 
-        transform(_buffer.data());
+        transform(_buffer.data(), 1);
 
         if constexpr(std::endian::big != std::endian::native)
         {
@@ -297,78 +406,8 @@ namespace dci::crypto::impl
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void Sha2_512::transform(const void* data)
-    {
-        return transform(static_cast<const std::uint64_t*>(data));
-    }
-
-    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    void Sha2_512::transform(const std::uint64_t* data)
+    void Sha2_512::transform(const void* data, std::size_t blocks)
     {
-        std::uint64_t a, b, c, d, e, f, g, h, s0, s1;
-        std::uint64_t T1, T2, *W512;
-
-        W512 = static_cast<std::uint64_t*>(static_cast<void*>(_buffer.data()));
-
-        a = _state[0];
-        b = _state[1];
-        c = _state[2];
-        d = _state[3];
-        e = _state[4];
-        f = _state[5];
-        g = _state[6];
-        h = _state[7];
-
-        int j = 0;
-        do
-        {
-            W512[j] = n2b(*data++);
-
-            T1 = h + Sigma1_512(e) + Ch(e, f, g) + K512[j] + W512[j];
-
-            T2 = Sigma0_512(a) + Maj(a, b, c);
-            h = g;
-            g = f;
-            f = e;
-            e = d + T1;
-            d = c;
-            c = b;
-            b = a;
-            a = T1 + T2;
-
-            j++;
-        }
-        while (j < 16);
-
-        do
-        {
-            s0 = W512[(j+1)&0x0f];
-            s0 = sigma0_512(s0);
-            s1 = W512[(j+14)&0x0f];
-            s1 = sigma1_512(s1);
-
-            T1 = h + Sigma1_512(e) + Ch(e, f, g) + K512[j] + (W512[j&0x0f] += s1 + W512[(j+9)&0x0f] + s0);
-            T2 = Sigma0_512(a) + Maj(a, b, c);
-            h = g;
-            g = f;
-            f = e;
-            e = d + T1;
-            d = c;
-            c = b;
-            b = a;
-            a = T1 + T2;
-
-            j++;
-        }
-        while (j < 80);
-
-        _state[0] += a;
-        _state[1] += b;
-        _state[2] += c;
-        _state[3] += d;
-        _state[4] += e;
-        _state[5] += f;
-        _state[6] += g;
-        _state[7] += h;
+        transformImpl(_state.data(), data, blocks);
     }
 }
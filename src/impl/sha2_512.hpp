@@ -35,8 +35,7 @@ namespace dci::crypto::impl
         void clear() override;
 
     private:
-        void transform(const void* data);
-        void transform(const std::uint64_t* data);
+        void transform(const void* data, std::size_t blocks);
 
         std::array<std::uint64_t, 8>    _state;
         std::uint64_t                   _bitcount;
@@ -0,0 +1,97 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include "rounds.hpp"
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2,bmi2")
+
+namespace dci::crypto::impl::sha2_512
+{
+    namespace
+    {
+        inline __m128i load128(const void* p)
+        {
+            return _mm_loadu_si128(static_cast<const __m128i*>(p));
+        }
+
+        template <int ROT>
+        inline __m256i rotr(__m256i v)
+        {
+            return _mm256_or_si256(_mm256_srli_epi64(v, ROT), _mm256_slli_epi64(v, 64-ROT));
+        }
+
+        inline __m256i sigma0(__m256i v)
+        {
+            return _mm256_xor_si256(_mm256_xor_si256(rotr<1>(v), rotr<8>(v)), _mm256_srli_epi64(v, 7));
+        }
+
+        inline __m256i sigma1(__m256i v)
+        {
+            return _mm256_xor_si256(_mm256_xor_si256(rotr<19>(v), rotr<61>(v)), _mm256_srli_epi64(v, 6));
+        }
+
+        inline void storeWk(std::uint64_t wk[2][80], std::size_t g, __m256i v)
+        {
+            _mm_store_si128(static_cast<__m128i*>(static_cast<void*>(wk[0] + 2*g)), _mm256_castsi256_si128(v));
+            _mm_store_si128(static_cast<__m128i*>(static_cast<void*>(wk[1] + 2*g)), _mm256_extracti128_si256(v, 1));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sha2_512_transform_avx2(std::uint64_t state[8], const void* vdata, std::size_t blocks)
+    {
+        const __m256i bswap = _mm256_set_epi64x(0x08090a0b0c0d0e0fll, 0x0001020304050607ll, 0x08090a0b0c0d0e0fll, 0x0001020304050607ll);
+        const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+
+        alignas(32) std::uint64_t wk[2][80];
+
+        while(blocks)
+        {
+            // schedule of sha2_512_transform_ssse3 for two blocks, one per 128-bit half; a lone
+            // last block goes to both halves, the high one is then ignored
+            const std::uint8_t* second = blocks > 1 ? data + 128 : data;
+
+            __m256i w[8];
+            #pragma GCC unroll 8
+            for(std::size_t g(0); g<8; ++g)
+            {
+                w[g] = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(load128(data + 16*g)), load128(second + 16*g), 1), bswap);
+                storeWk(wk, g, _mm256_add_epi64(w[g], _mm256_broadcastsi128_si256(load128(k + 2*g))));
+            }
+
+            #pragma GCC unroll 32
+            for(std::size_t g(8); g<40; ++g)
+            {
+                w[g&7] = _mm256_add_epi64(
+                             _mm256_add_epi64(w[g&7], sigma0(_mm256_alignr_epi8(w[(g+1)&7], w[g&7], 8))),
+                             _mm256_add_epi64(_mm256_alignr_epi8(w[(g+5)&7], w[(g+4)&7], 8), sigma1(w[(g+7)&7])));
+                storeWk(wk, g, _mm256_add_epi64(w[g&7], _mm256_broadcastsi128_si256(load128(k + 2*g))));
+            }
+
+            rounds(state, wk[0]);
+            if(blocks == 1)
+            {
+                break;
+            }
+
+            rounds(state, wk[1]);
+            blocks -= 2;
+            data += 256;
+        }
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
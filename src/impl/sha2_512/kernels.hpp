@@ -0,0 +1,23 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dci::crypto::impl::sha2_512
+{
+    // round constants, fips 180-4 section 4.2.3
+    extern const std::uint64_t k[80];
+
+    // state = compression of each of blocks consecutive 128-byte blocks of data, in order;
+    // scalar rounds, message schedule in xmm registers, or for two blocks at once in ymm ones
+    void sha2_512_transform_ssse3(std::uint64_t state[8], const void* data, std::size_t blocks);
+    void sha2_512_transform_avx2(std::uint64_t state[8], const void* data, std::size_t blocks);
+}
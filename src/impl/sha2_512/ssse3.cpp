@@ -0,0 +1,85 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "kernels.hpp"
+#include "rounds.hpp"
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+
+namespace dci::crypto::impl::sha2_512
+{
+    namespace
+    {
+        inline __m128i load(const void* p)
+        {
+            return _mm_loadu_si128(static_cast<const __m128i*>(p));
+        }
+
+        inline void store(void* p, __m128i v)
+        {
+            _mm_storeu_si128(static_cast<__m128i*>(p), v);
+        }
+
+        template <int ROT>
+        inline __m128i rotr(__m128i v)
+        {
+            return _mm_or_si128(_mm_srli_epi64(v, ROT), _mm_slli_epi64(v, 64-ROT));
+        }
+
+        inline __m128i sigma0(__m128i v)
+        {
+            return _mm_xor_si128(_mm_xor_si128(rotr<1>(v), rotr<8>(v)), _mm_srli_epi64(v, 7));
+        }
+
+        inline __m128i sigma1(__m128i v)
+        {
+            return _mm_xor_si128(_mm_xor_si128(rotr<19>(v), rotr<61>(v)), _mm_srli_epi64(v, 6));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sha2_512_transform_ssse3(std::uint64_t state[8], const void* vdata, std::size_t blocks)
+    {
+        const __m128i bswap = _mm_set_epi64x(0x08090a0b0c0d0e0fll, 0x0001020304050607ll);
+        const std::uint8_t* data = static_cast<const std::uint8_t*>(vdata);
+
+        alignas(16) std::uint64_t wk[80];
+
+        for(; blocks; --blocks, data += 128)
+        {
+            // w[g&7] holds schedule words 2g, 2g+1
+            __m128i w[8];
+            #pragma GCC unroll 8
+            for(std::size_t g(0); g<8; ++g)
+            {
+                w[g] = _mm_shuffle_epi8(load(data + 16*g), bswap);
+                store(wk + 2*g, _mm_add_epi64(w[g], load(k + 2*g)));
+            }
+
+            #pragma GCC unroll 32
+            for(std::size_t g(8); g<40; ++g)
+            {
+                w[g&7] = _mm_add_epi64(
+                             _mm_add_epi64(w[g&7], sigma0(_mm_alignr_epi8(w[(g+1)&7], w[g&7], 8))),
+                             _mm_add_epi64(_mm_alignr_epi8(w[(g+5)&7], w[(g+4)&7], 8), sigma1(w[(g+7)&7])));
+                store(wk + 2*g, _mm_add_epi64(w[g&7], load(k + 2*g)));
+            }
+
+            rounds(state, wk);
+        }
+    }
+}
+
+#pragma GCC pop_options
+
+#endif
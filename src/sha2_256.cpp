@@ -20,6 +20,12 @@ namespace dci::crypto
         };
     }
 
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Sha2_256::hashBatch(const Sha2_256Job* jobs, std::size_t count)
+    {
+        return impl::Sha2_256::hashBatch(jobs, count);
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     Sha2_256::Sha2_256(std::size_t digestSize)
         : himpl::FaceLayout<Sha2_256, impl::Sha2_256, Hash>{digestSize}
@@ -0,0 +1,180 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include <dci/crypto.hpp>
+#include <dci/utils/b2h.hpp>
+#include <dci/utils/h2b.hpp>
+
+using namespace dci::crypto;
+using namespace dci::utils;
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(crypto, aesGcm)
+{
+    {
+        // gcm spec test case 2, aes-128
+        AesGcm a;
+        std::vector<uint8_t> key(16);
+        std::vector<uint8_t> nonce(12);
+        std::vector<uint8_t> text(16);
+        std::vector<uint8_t> mac(16);
+
+        a.setKey(key.data(), key.size());
+        a.start(nonce.data(), nonce.size());
+        a.encipher(text.data(), text.data(), text.size());
+        a.encipherFinish(mac.data());
+
+        EXPECT_EQ(b2h(text.data(), text.size()), "3088adec066b3a293f822c9b172bef87");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "bae6744dc2ce31db5fa3762b2175dbfd");
+    }
+
+    {
+        // gcm spec test case 8, aes-192
+        AesGcm a;
+        std::vector<uint8_t> key(24);
+        std::vector<uint8_t> nonce(12);
+        std::vector<uint8_t> text(16);
+        std::vector<uint8_t> mac(16);
+
+        a.setKey(key.data(), key.size());
+        a.start(nonce.data(), nonce.size());
+        a.encipher(text.data(), text.data(), text.size());
+        a.encipherFinish(mac.data());
+
+        EXPECT_EQ(b2h(text.data(), text.size()), "897e42c7700fef14c162e734480b6f00");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "f25fd808309372bae84f4d8557410fbf");
+    }
+
+    {
+        // test cases 13 and 14, aes-256
+        AesGcm a;
+        std::vector<uint8_t> key(32);
+        std::vector<uint8_t> nonce(12);
+        std::vector<uint8_t> text(16);
+        std::vector<uint8_t> mac(16);
+
+        a.setKey(key.data(), key.size());
+        a.start(nonce.data(), nonce.size());
+        a.encipherFinish(mac.data());
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "35f0a8bf7c54639b9a364b1f4cbc37b8");
+
+        a.start(nonce.data(), nonce.size());
+        a.encipher(text.data(), text.data(), text.size());
+        a.encipherFinish(mac.data());
+        EXPECT_EQ(b2h(text.data(), text.size()), "ec7a04d3d406b6e670e45c3dab3fd981");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "0d1d8c7a9999b60f62b5895b4da89b91");
+    }
+
+    std::vector<uint8_t> key = h2b("efff9e29685637c1d6a6f84976033880efff9e29685637c1d6a6f84976033880");
+    std::vector<uint8_t> ad = h2b("efdeafeceddaebfeefdeafeceddaebfebadaad2d");
+    std::vector<uint8_t> plain = h2b("9d1323528f48605e5a95905cfa5f62a9687a9a3551437fade2c403d3a813a827c1c3c05959869035f2fce042946a5b521ba6de5faad06e75ab36b793");
+
+    {
+        // test case 16, in pieces
+        AesGcm a;
+        std::vector<uint8_t> nonce = h2b("acefabebafecbddaedac8f88");
+        std::vector<uint8_t> text = plain;
+        std::vector<uint8_t> mac(16);
+
+        a.setKey(key.data(), key.size());
+        a.setAd(ad.data(), ad.size());
+        a.start(nonce.data(), nonce.size());
+        a.encipher(text.data(), text.data(), 7);
+        a.encipher(text.data()+7, text.data()+7, text.size()-7);
+        a.encipherFinish(mac.data());
+
+        EXPECT_EQ(b2h(text.data(), text.size()), "25d21c0f9965d7704ff7733aa24824d746a3c8cdfb5e0c9c57892adb52551daac80be88495d0bbd37a0bb801652888835c6fe13639aba7a0cb9c6f26");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "67cfe6ecf0e47186dcfd8835bbd255b1");
+
+        a.start(nonce.data(), nonce.size());
+        a.decipher(text.data(), text.data(), text.size());
+        EXPECT_TRUE(a.decipherFinish(mac.data()));
+        EXPECT_EQ(text, plain);
+
+        mac[0] ^= 1;
+        a.start(nonce.data(), nonce.size());
+        a.decipher(text.data(), text.data(), text.size());
+        EXPECT_FALSE(a.decipherFinish(mac.data()));
+    }
+
+    {
+        // test case 18, 60 byte nonce
+        AesGcm a;
+        std::vector<uint8_t> nonce = h2b("393122d58f48605e5509c9a5ff2596aaa6a7598335f4d71a4e3c302d3a817a823c0c9c1565085993cf0f2e24a9b6254561eabd5f0aeda6756a733bb9");
+        std::vector<uint8_t> text = plain;
+        std::vector<uint8_t> mac(16);
+
+        a.setKey(key.data(), key.size());
+        a.setAd(ad.data(), ad.size());
+        a.start(nonce.data(), nonce.size());
+        a.encipher(text.data(), text.data(), text.size());
+        a.encipherFinish(mac.data());
+
+        EXPECT_EQ(b2h(text.data(), text.size()), "a5d8fef2c0e9351f7fd5873556e9a202ee2b2ba2faed46910a85baf4f647b64ff00c3c7b082f4454d23abe1f5c8dc2ed2a14987902e08fe244eae7f3");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "4aa42866eec1e80b8c5b4dfca59e1fa9");
+    }
+
+    {
+        // 8-block paths against a block at a time
+        AesGcm bulk, piecewise;
+        std::vector<uint8_t> nonce = h2b("acefabebafecbddaedac8f88");
+        bulk.setKey(key.data(), key.size());
+        piecewise.setKey(key.data(), key.size());
+
+        std::vector<uint8_t> text(10000);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*5);
+        }
+        std::vector<uint8_t> expected = text;
+        std::vector<uint8_t> mac(16), expectedMac(16);
+
+        bulk.start(nonce.data(), nonce.size());
+        bulk.encipher(text.data(), text.data(), text.size());
+        bulk.encipherFinish(mac.data());
+
+        piecewise.start(nonce.data(), nonce.size());
+        for(std::size_t i(0); i<expected.size(); i += 15)
+        {
+            std::size_t len = std::min(std::size_t{15}, expected.size()-i);
+            piecewise.encipher(expected.data()+i, expected.data()+i, len);
+        }
+        piecewise.encipherFinish(expectedMac.data());
+
+        EXPECT_EQ(text, expected);
+        EXPECT_EQ(mac, expectedMac);
+    }
+
+    if constexpr(sizeof(std::size_t) > 4)
+    {
+        // 2^32-2 blocks per message, a span crossing that is refused before it touches out
+        AesGcm a;
+        std::vector<uint8_t> nonce(12);
+        std::vector<uint8_t> text(32, 0x5a);
+        std::vector<uint8_t> mac(16);
+        const std::size_t maxTextLen = 16 * ((std::size_t{1} << 32) - 2);
+
+        a.setKey(key.data(), key.size());
+        a.start(nonce.data(), nonce.size());
+        EXPECT_TRUE(a.encipher(text.data(), text.data(), 16));
+        EXPECT_FALSE(a.encipher(text.data()+16, text.data()+16, maxTextLen - 15));
+        EXPECT_EQ(text[16], 0x5a);
+        EXPECT_FALSE(a.encipher(text.data()+16, text.data()+16, 1));
+
+        // the mac of the empty message no longer passes once a span was refused
+        a.start(nonce.data(), nonce.size());
+        a.encipherFinish(mac.data());
+
+        a.start(nonce.data(), nonce.size());
+        EXPECT_FALSE(a.decipher(text.data(), text.data(), maxTextLen + 1));
+        EXPECT_FALSE(a.decipherFinish(mac.data()));
+
+        a.start(nonce.data(), nonce.size());
+        EXPECT_TRUE(a.decipherFinish(mac.data()));
+    }
+}
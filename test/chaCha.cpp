@@ -44,4 +44,177 @@ TEST(crypto, chaCha)
         h.cipher(text.data(), text.data(), text.size());
         EXPECT_EQ(b2h(text.data(), text.size()), "dd133a03ebb78479a3607c6857f080782e4cb6e6159bd0ab1c95b0c7f915911031523eb60ad522184caa44");
     }
+
+    {
+        ChaCha h;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> iv = h2b("00000000000000a400000000");
+        std::string text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+        h.setKey(key.data(), key.size());
+        h.setIv(iv.data(), iv.size());
+        h.seek(64);
+        h.cipher(text.data(), text.data(), text.size());
+        EXPECT_EQ(b2h(text.data(), text.size()), "e6e253a952869f0814ab7082ddd096189ee7a7ced134062ca072faccdff9eab09fb1565c257433baf895d3badc263b7561936d426e1525baf835c053f980168d70acd0fb05d0a616653ae880a8226be525cb15d461cc8f6018c89ea17b977363a59fb0fb473ab56e4bb0e8de2f87e52478d4");
+    }
+
+    {
+        ChaCha h;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> iv = h2b("00000090000000a400000000");
+        std::vector<uint8_t> stream(4096);
+        h.setKey(key.data(), key.size());
+        h.setIv(iv.data(), iv.size());
+        h.cipher(nullptr, stream.data(), 100);
+        h.cipher(nullptr, stream.data()+100, stream.size()-100);
+
+        std::vector<uint8_t> digest(32);
+        sha2_256(stream.data(), stream.size(), digest.data());
+        EXPECT_EQ(b2h(digest.data(), digest.size()), "8d1b48fe6bbc83c2121d59101d867d7ff3b06433a719160ba8c4b80239958d7e");
+    }
+
+    {
+        ChaCha bulk, piecewise;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> iv = h2b("00000090000000a400000000");
+        bulk.setKey(key.data(), key.size());
+        bulk.setIv(iv.data(), iv.size());
+        piecewise.setKey(key.data(), key.size());
+        piecewise.setIv(iv.data(), iv.size());
+
+        std::vector<uint8_t> text(5000);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i);
+        }
+        std::vector<uint8_t> expected = text;
+
+        bulk.cipher(text.data(), text.data(), 3);
+        bulk.cipher(text.data()+3, text.data()+3, text.size()-3);
+
+        for(std::size_t i(0); i<expected.size(); i += 7)
+        {
+            std::size_t len = std::min(std::size_t{7}, expected.size()-i);
+            piecewise.cipher(expected.data()+i, expected.data()+i, len);
+        }
+
+        EXPECT_EQ(text, expected);
+    }
+
+    {
+        ChaCha serial, parallel;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> iv = h2b("00000090000000a400000000");
+        serial.setKey(key.data(), key.size());
+        serial.setIv(iv.data(), iv.size());
+        parallel.setKey(key.data(), key.size());
+        parallel.setIv(iv.data(), iv.size());
+
+        std::vector<uint8_t> text(300000+100);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*7);
+        }
+        std::vector<uint8_t> expected = text;
+
+        serial.cipher(expected.data(), expected.data(), 33);
+        serial.cipher(expected.data()+33, expected.data()+33, 300000);
+        serial.cipher(expected.data()+300033, expected.data()+300033, 67);
+
+        parallel.cipher(text.data(), text.data(), 33);
+        parallel.cipherParallel(text.data()+33, text.data()+33, 300000, 4);
+        parallel.cipher(text.data()+300033, text.data()+300033, 67);
+
+        EXPECT_EQ(text, expected);
+    }
+
+    {
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<std::vector<uint8_t>> ivs(20);
+        std::vector<std::vector<uint8_t>> texts(ivs.size());
+        std::vector<std::vector<uint8_t>> expected(ivs.size());
+        std::vector<ChaChaJob> jobs(ivs.size());
+        for(std::size_t i(0); i<ivs.size(); ++i)
+        {
+            ivs[i].resize(12);
+            ivs[i][0] = static_cast<uint8_t>(i);
+
+            texts[i].resize(i*37);
+            for(std::size_t j(0); j<texts[i].size(); ++j)
+            {
+                texts[i][j] = static_cast<uint8_t>(i+j);
+            }
+
+            ChaCha h;
+            h.setKey(key.data(), key.size());
+            h.setIv(ivs[i].data(), ivs[i].size());
+            h.seek(64*i);
+            expected[i].resize(texts[i].size());
+            h.cipher(texts[i].data(), expected[i].data(), texts[i].size());
+
+            jobs[i] = ChaChaJob{key.data(), key.size(), ivs[i].data(), ivs[i].size(), i, texts[i].data(), texts[i].data(), texts[i].size()};
+        }
+
+        ChaCha::cipherBatch(jobs.data(), jobs.size());
+        EXPECT_EQ(texts, expected);
+    }
+
+    {
+        ChaCha h8(8), h12(12);
+        std::vector<uint8_t> key = h2b("0000000000000000000000000000000000000000000000000000000000000000");
+        std::vector<uint8_t> stream(64);
+
+        h8.setKey(key.data(), key.size());
+        h8.cipher(nullptr, stream.data(), stream.size());
+        EXPECT_EQ(b2h(stream.data(), stream.size()), "e300fef298f5046df7b58b8ef1905a1ac248e03ceca9f7b381b11e88fe17a1e189c41e279b12f614f944357654d6659113a4243aad680b1083b7df8be0c0ef24");
+
+        h12.setKey(key.data(), key.size());
+        h12.cipher(nullptr, stream.data(), stream.size());
+        EXPECT_EQ(b2h(stream.data(), stream.size()), "b94fa9a670559f3518f1ec21f562385d40923cbb940e4741e700985ae2ea51f550468f972da73e0cc28e8243caafc897a326f9c20aed969116b08ef2143162eb");
+    }
+
+    {
+        ChaCha full, sought;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        full.setKey(key.data(), key.size());
+        sought.setKey(key.data(), key.size());
+
+        std::vector<uint8_t> stream(3000);
+        full.cipher(nullptr, stream.data(), stream.size());
+
+        for(std::size_t offset : {std::size_t{0}, std::size_t{1}, std::size_t{63}, std::size_t{64}, std::size_t{100}, std::size_t{1500}})
+        {
+            std::vector<uint8_t> part(stream.size() - offset);
+            sought.setIv(nullptr, 0);
+            sought.seek(offset);
+            sought.cipher(nullptr, part.data(), 5);
+            sought.cipher(nullptr, part.data()+5, part.size()-5);
+            EXPECT_TRUE(std::equal(part.begin(), part.end(), stream.begin()+static_cast<std::ptrdiff_t>(offset)));
+        }
+    }
+
+    {
+        ChaCha reused;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> iv = h2b("00102030405060708090a0b0c0d0e0f00111213141516171");
+        reused.setKey(key.data(), key.size());
+
+        for(uint8_t message(0); message<4; ++message)
+        {
+            iv[20] = message;
+            if(message == 3)
+            {
+                iv[0] ^= 1;
+            }
+
+            ChaCha fresh;
+            fresh.setKey(key.data(), key.size());
+            fresh.setIv(iv.data(), iv.size());
+            reused.setIv(iv.data(), iv.size());
+
+            std::vector<uint8_t> expected(200), stream(200);
+            fresh.cipher(nullptr, expected.data(), expected.size());
+            reused.cipher(nullptr, stream.data(), stream.size());
+            EXPECT_EQ(stream, expected);
+        }
+    }
 }
@@ -93,4 +93,175 @@ TEST(crypto, chaCha20Poly1305)
         EXPECT_FALSE(res);
     }
 
+    {
+        // several spans at once against small pieces, then back
+        ChaCha20Poly1305 whole, pieces;
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> nonce = h2b("000000000000000000000070");
+        std::vector<uint8_t> text(10000);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*5);
+        }
+
+        std::vector<uint8_t> ctext1(text.size()), ctext2(text.size()), mac1(16), mac2(16);
+
+        whole.setKey(key.data(), key.size());
+        whole.start(nonce.data(), nonce.size());
+        whole.encipher(text.data(), ctext1.data(), text.size());
+        whole.encipherFinish(mac1.data());
+
+        pieces.setKey(key.data(), key.size());
+        pieces.start(nonce.data(), nonce.size());
+        for(std::size_t i(0); i<text.size(); i += 999)
+        {
+            std::size_t len = std::min(std::size_t{999}, text.size()-i);
+            pieces.encipher(text.data()+i, ctext2.data()+i, len);
+        }
+        pieces.encipherFinish(mac2.data());
+
+        EXPECT_EQ(ctext1, ctext2);
+        EXPECT_EQ(mac1, mac2);
+
+        std::vector<uint8_t> back(text.size());
+        whole.start(nonce.data(), nonce.size());
+        whole.decipher(ctext1.data(), back.data(), back.size());
+        EXPECT_TRUE(whole.decipherFinish(mac1.data()));
+        EXPECT_EQ(back, text);
+    }
+
+    {
+        // scattered one-shot against the streaming calls
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> nonce = h2b("000000000000000000000070");
+        std::vector<uint8_t> ad = h2b("0123456789abcdef01");
+        std::string header = "header", payload(300, 'p'), trailer = "trailer";
+        std::string text = header + payload + trailer;
+
+        ChaCha20Poly1305 a;
+        std::string expected = text;
+        std::vector<uint8_t> expectedMac(16);
+        a.setKey(key.data(), key.size());
+        a.setAd(ad.data(), ad.size());
+        a.start(nonce.data(), nonce.size());
+        a.encipher(expected.data(), expected.data(), expected.size());
+        a.encipherFinish(expectedMac.data());
+
+        std::string ctext(text.size(), '\0');
+        std::vector<uint8_t> mac(16);
+        ConstIov in[] = {{header.data(), header.size()}, {payload.data(), payload.size()}, {trailer.data(), trailer.size()}};
+        Iov out[] = {{ctext.data(), 100}, {ctext.data()+100, ctext.size()-100}};
+        ChaCha20Poly1305::seal(key.data(), key.size(), nonce.data(), nonce.size(), ad.data(), ad.size(), in, 3, out, 2, mac.data());
+
+        EXPECT_EQ(ctext, expected);
+        EXPECT_EQ(mac, expectedMac);
+
+        ConstIov cipherIn[] = {{ctext.data(), 10}, {ctext.data()+10, ctext.size()-10}};
+        Iov plainOut[] = {{ctext.data(), 10}, {ctext.data()+10, ctext.size()-10}};
+        EXPECT_TRUE(ChaCha20Poly1305::open(key.data(), key.size(), nonce.data(), nonce.size(), ad.data(), ad.size(), cipherIn, 2, plainOut, 2, mac.data()));
+        EXPECT_EQ(ctext, text);
+
+        ctext = expected;
+        mac[0] ^= 1;
+        EXPECT_FALSE(ChaCha20Poly1305::open(key.data(), key.size(), nonce.data(), nonce.size(), ad.data(), ad.size(), cipherIn, 2, plainOut, 2, mac.data()));
+        EXPECT_EQ(ctext, expected);
+    }
+
+    {
+        // associated data fed in pieces after start
+        ChaCha20Poly1305 a;
+        std::vector<uint8_t> key = h2b("000102030405060708090a0b0c0d0e0f");
+        std::vector<uint8_t> ad = h2b("0123456789abcdef");
+        std::vector<uint8_t> nonce = h2b("fedcba9876543210");
+        std::string text = "The quick brown fox jumps over the lazy dog";
+        std::vector<uint8_t> mac(16);
+
+        a.setKey(key.data(), key.size());
+        a.start(nonce.data(), nonce.size());
+        a.addAd(ad.data(), 3);
+        a.addAd(ad.data()+3, ad.size()-3);
+        a.encipher(text.data(), text.data(), text.size());
+        a.encipherFinish(mac.data());
+
+        EXPECT_EQ(b2h(text.data(), text.size()), "4d47deb9d36464ecb7b08bc0365ce5d8c5e67a8af058b811a9d38f6ccfff094d1e1e9ba53069f7e0ea3a50");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "c62d5c2e8af841664d18f7b82c6696e8");
+    }
+
+    {
+        // batch against one-shot calls, one forged packet on the way back
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> ad = h2b("0123456789abcdef01");
+
+        std::vector<std::vector<uint8_t>> nonces(20), texts(20), ctexts(20), macs(20);
+        std::vector<ChaCha20Poly1305Packet> packets(20);
+        for(std::size_t i(0); i<packets.size(); ++i)
+        {
+            nonces[i].resize(i%3 ? 12 : 24);
+            nonces[i][0] = static_cast<uint8_t>(i);
+
+            texts[i].resize(i*29);
+            for(std::size_t j(0); j<texts[i].size(); ++j)
+            {
+                texts[i][j] = static_cast<uint8_t>(i+j);
+            }
+
+            ctexts[i].resize(texts[i].size());
+            macs[i].resize(16);
+            packets[i] = ChaCha20Poly1305Packet{nonces[i].data(), nonces[i].size(), ad.data(), i%ad.size(), texts[i].data(), ctexts[i].data(), texts[i].size(), macs[i].data()};
+        }
+
+        ChaCha20Poly1305::sealBatch(key.data(), key.size(), packets.data(), packets.size());
+
+        for(std::size_t i(0); i<packets.size(); ++i)
+        {
+            std::vector<uint8_t> expected(texts[i].size()), mac(16);
+            ConstIov in {texts[i].data(), texts[i].size()};
+            Iov out {expected.data(), expected.size()};
+            ChaCha20Poly1305::seal(key.data(), key.size(), nonces[i].data(), nonces[i].size(), ad.data(), i%ad.size(), &in, 1, &out, 1, mac.data());
+
+            EXPECT_EQ(ctexts[i], expected);
+            EXPECT_EQ(macs[i], mac);
+
+            packets[i].in = ctexts[i].data();
+            packets[i].out = ctexts[i].data();
+        }
+
+        macs[7][5] ^= 1;
+
+        uint64_t valid = 0;
+        EXPECT_EQ(ChaCha20Poly1305::openBatch(key.data(), key.size(), packets.data(), packets.size(), &valid), packets.size()-1);
+        EXPECT_EQ(valid, ((uint64_t{1} << packets.size()) - 1) & ~(uint64_t{1} << 7));
+
+        for(std::size_t i(0); i<packets.size(); ++i)
+        {
+            if(i != 7)
+            {
+                EXPECT_EQ(ctexts[i], texts[i]);
+            }
+        }
+    }
+
+    {
+        // verified in one call, a forged message is left as is
+        ChaCha20Poly1305 a;
+        std::vector<uint8_t> key = h2b("000102030405060708090a0b0c0d0e0f");
+        std::vector<uint8_t> ad = h2b("0123456789abcdef");
+        std::vector<uint8_t> nonce = h2b("fedcba9876543210");
+        std::vector<uint8_t> ctext = h2b("4d47deb9d36464ecb7b08bc0365ce5d8c5e67a8af058b811a9d38f6ccfff094d1e1e9ba53069f7e0ea3a50");
+        std::vector<uint8_t> mac = h2b("c62d5c2e8af841664d18f7b82c6696e8");
+        std::string text(ctext.size(), '\0');
+
+        a.setKey(key.data(), key.size());
+        a.setAd(ad.data(), ad.size());
+
+        a.start(nonce.data(), nonce.size());
+        EXPECT_TRUE(a.decipherVerified(ctext.data(), text.data(), ctext.size(), mac.data()));
+        EXPECT_EQ(text, "The quick brown fox jumps over the lazy dog");
+
+        text.assign(ctext.size(), '\0');
+        ctext[3] ^= 1;
+        a.start(nonce.data(), nonce.size());
+        EXPECT_FALSE(a.decipherVerified(ctext.data(), text.data(), ctext.size(), mac.data()));
+        EXPECT_EQ(text, std::string(ctext.size(), '\0'));
+    }
 }
@@ -0,0 +1,116 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include <dci/crypto.hpp>
+#include <dci/utils/b2h.hpp>
+#include <dci/utils/h2b.hpp>
+
+using namespace dci::crypto;
+using namespace dci::utils;
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(crypto, chaCha20Poly1305Session)
+{
+    {
+        // rfc8439 2.8.2, nonce 07000000 4041424344454647
+        ChaCha20Poly1305Session s;
+        std::vector<uint8_t> key = h2b("08182838485868788898a8b8c8d8e8f809192939495969798999a9b9c9d9e9f9");
+        std::vector<uint8_t> prefix = h2b("70000000");
+        std::vector<uint8_t> ad = h2b("051525350c1c2c3c4c5c6c7c");
+        std::string text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+        std::vector<uint8_t> mac(16);
+
+        s.setKey(key.data(), key.size());
+        s.setNoncePrefix(prefix.data(), prefix.size());
+        s.setCounter(0x4746454443424140);
+        EXPECT_TRUE(s.seal(ad.data(), ad.size(), text.data(), text.data(), text.size(), mac.data()));
+
+        EXPECT_EQ(b2h(text.data(), text.size()), "3da1d84346e806bdb768facb35fee72c4adade1592e680ef9a2e5b7a63ee266dd3eb4ae5c89a762128afbf96ad2927b8a117eda0e960b092506d5a6be7dcb36329dddbf7d277b8c88930ea3e8290b185af3b424eaf6d5749555808b884137dcbf34fed0fe8b4a7d95e672d5668ec6cb41661");
+        EXPECT_EQ(b2h(mac.data(), mac.size()), "a11eb095f4902ea6e709e2bc0d066019");
+        EXPECT_EQ(s.counter(), 0x4746454443424141u);
+    }
+
+    {
+        // a run of messages across several key batches matches the one-shot seal, the receiver
+        // skips a forged one and stays in step
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> prefix = h2b("dcba");
+        std::vector<uint8_t> ad = h2b("0123456789abcdef");
+
+        ChaCha20Poly1305Session sender, receiver;
+        sender.setKey(key.data(), key.size());
+        sender.setNoncePrefix(prefix.data(), prefix.size());
+        sender.setCounter(3);
+        receiver = sender;
+
+        for(std::uint64_t i(3); i<23; ++i)
+        {
+            std::vector<uint8_t> text(i*29);
+            for(std::size_t j(0); j<text.size(); ++j)
+            {
+                text[j] = static_cast<uint8_t>(i+j);
+            }
+
+            std::vector<uint8_t> nonce(12);
+            nonce[0] = 0xcd;
+            nonce[1] = 0xab;
+            nonce[4] = static_cast<uint8_t>(i);
+
+            std::vector<uint8_t> expected(text.size()), expectedMac(16);
+            const ConstIov in {text.data(), text.size()};
+            const Iov out {expected.data(), expected.size()};
+            ChaCha20Poly1305::seal(key.data(), key.size(), nonce.data(), nonce.size(), ad.data(), ad.size(), &in, 1, &out, 1, expectedMac.data());
+
+            std::vector<uint8_t> ctext(text.size()), mac(16);
+            EXPECT_TRUE(sender.seal(ad.data(), ad.size(), text.data(), ctext.data(), text.size(), mac.data()));
+            EXPECT_EQ(ctext, expected);
+            EXPECT_EQ(mac, expectedMac);
+
+            std::vector<uint8_t> plain(text.size());
+            if(i == 10)
+            {
+                mac[15] ^= 1;
+                EXPECT_FALSE(receiver.open(ad.data(), ad.size(), ctext.data(), plain.data(), ctext.size(), mac.data()));
+                EXPECT_EQ(receiver.counter(), i);
+                mac[15] ^= 1;
+            }
+
+            EXPECT_TRUE(receiver.open(ad.data(), ad.size(), ctext.data(), plain.data(), ctext.size(), mac.data()));
+            EXPECT_EQ(plain, text);
+        }
+
+        EXPECT_EQ(sender.counter(), 23u);
+        EXPECT_EQ(receiver.counter(), 23u);
+    }
+
+    {
+        // the last counter values: 2^64-2 is used, 2^64-1 never is
+        std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+        std::vector<uint8_t> text(40, 7), ctext(text.size()), plain(text.size()), mac(16);
+
+        ChaCha20Poly1305Session sender, receiver;
+        sender.setKey(key.data(), key.size());
+        sender.setCounter(~0ull - 1);
+        receiver = sender;
+
+        EXPECT_TRUE(sender.seal(nullptr, 0, text.data(), ctext.data(), text.size(), mac.data()));
+        EXPECT_EQ(sender.counter(), ~0ull);
+        EXPECT_TRUE(receiver.open(nullptr, 0, ctext.data(), plain.data(), ctext.size(), mac.data()));
+        EXPECT_EQ(plain, text);
+
+        std::vector<uint8_t> untouched = ctext;
+        EXPECT_FALSE(sender.seal(nullptr, 0, text.data(), ctext.data(), text.size(), mac.data()));
+        EXPECT_EQ(ctext, untouched);
+        EXPECT_EQ(sender.counter(), ~0ull);
+
+        sender.setCounter(~0ull);
+        EXPECT_FALSE(sender.seal(nullptr, 0, text.data(), ctext.data(), text.size(), mac.data()));
+        EXPECT_FALSE(receiver.open(nullptr, 0, ctext.data(), plain.data(), ctext.size(), mac.data()));
+        EXPECT_EQ(sender.counter(), ~0ull);
+    }
+}
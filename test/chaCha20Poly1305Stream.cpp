@@ -0,0 +1,180 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include <dci/crypto.hpp>
+#include <dci/utils/b2h.hpp>
+#include <dci/utils/h2b.hpp>
+
+using namespace dci::crypto;
+using namespace dci::utils;
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(crypto, chaCha20Poly1305Stream)
+{
+    std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+    std::vector<uint8_t> prefix = h2b("1f2e3d4c5b6a79");
+    std::vector<uint8_t> ad = h2b("0123456789abcdef");
+
+    std::vector<uint8_t> text(5500);
+    for(std::size_t i(0); i<text.size(); ++i)
+    {
+        text[i] = static_cast<uint8_t>(i*3);
+    }
+
+    ChaCha20Poly1305Stream writer;
+    writer.setKey(key.data(), key.size());
+    writer.setAd(ad.data(), ad.size());
+    writer.setChunkSize(1000);
+    writer.setWorkers(4);
+
+    std::vector<uint8_t> sealed(ChaCha20Poly1305Stream::sealedSize(text.size(), 1000));
+    EXPECT_EQ(sealed.size(), 5500u + 6*16);
+
+    writer.start(prefix.data(), prefix.size());
+    EXPECT_TRUE(writer.encipher(text.data(), 3000, sealed.data(), false));
+    EXPECT_TRUE(writer.encipher(text.data()+3000, 2500, sealed.data()+3*1016, true));
+
+    {
+        // chunk by chunk, the same as plain messages under the derived nonces
+        for(std::size_t i(0); i<6; ++i)
+        {
+            std::vector<uint8_t> nonce = prefix;
+            nonce.insert(nonce.end(), {0, 0, 0, static_cast<uint8_t>(i), static_cast<uint8_t>(i == 5 ? 1 : 0)});
+
+            const std::size_t size = i == 5 ? 500 : 1000;
+            std::vector<uint8_t> expected(size), mac(16);
+            const ConstIov in {text.data() + i*1000, size};
+            const Iov out {expected.data(), size};
+            ChaCha20Poly1305::seal(key.data(), key.size(), nonce.data(), nonce.size(), ad.data(), ad.size(), &in, 1, &out, 1, mac.data());
+
+            EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sealed.begin() + static_cast<std::ptrdiff_t>(i*1016)));
+            EXPECT_TRUE(std::equal(mac.begin(), mac.end(), sealed.begin() + static_cast<std::ptrdiff_t>(i*1016 + size)));
+        }
+    }
+
+    ChaCha20Poly1305Stream reader;
+    reader.setKey(key.data(), key.size());
+    reader.setAd(ad.data(), ad.size());
+    reader.setChunkSize(1000);
+
+    {
+        // released as the chunks arrive
+        std::vector<uint8_t> plain(text.size());
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(reader.decipher(sealed.data(), 1016, plain.data(), false));
+        EXPECT_TRUE(reader.decipher(sealed.data()+1016, 4*1016, plain.data()+1000, false));
+        EXPECT_TRUE(reader.decipher(sealed.data()+5*1016, 516, plain.data()+5000, true));
+        EXPECT_EQ(plain, text);
+        EXPECT_FALSE(reader.decipher(sealed.data(), 1016, plain.data(), false));
+    }
+
+    {
+        // all at once in parallel
+        std::vector<uint8_t> plain(text.size());
+        reader.setWorkers(3);
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(reader.decipher(sealed.data(), sealed.size(), plain.data(), true));
+        EXPECT_EQ(plain, text);
+    }
+
+    {
+        // truncated at a chunk boundary
+        std::vector<uint8_t> plain(text.size());
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_FALSE(reader.decipher(sealed.data(), 5*1016, plain.data(), true));
+    }
+
+    {
+        // reordered
+        std::vector<uint8_t> swapped = sealed;
+        std::swap_ranges(swapped.begin(), swapped.begin()+1016, swapped.begin()+1016);
+
+        std::vector<uint8_t> plain(text.size());
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_FALSE(reader.decipher(swapped.data(), swapped.size(), plain.data(), true));
+    }
+
+    {
+        // forged chunk, the others still come out, the forged one is left as is
+        std::vector<uint8_t> forged = sealed;
+        forged[2*1016 + 7] ^= 1;
+
+        std::vector<uint8_t> plain(text.size());
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_FALSE(reader.decipher(forged.data(), forged.size(), plain.data(), true));
+        EXPECT_TRUE(std::equal(text.begin(), text.begin()+2000, plain.begin()));
+        EXPECT_EQ(std::vector<uint8_t>(plain.begin()+2000, plain.begin()+3000), std::vector<uint8_t>(1000));
+        EXPECT_FALSE(reader.decipher(sealed.data(), 1016, plain.data(), false));
+    }
+
+    {
+        // random access
+        std::vector<uint8_t> plain(1000);
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(reader.seek(3));
+        EXPECT_TRUE(reader.decipher(sealed.data()+3*1016, 1016, plain.data(), false));
+        EXPECT_TRUE(std::equal(plain.begin(), plain.end(), text.begin()+3000));
+
+        EXPECT_TRUE(reader.seek(5));
+        EXPECT_TRUE(reader.decipher(sealed.data()+5*1016, 516, plain.data(), true));
+        EXPECT_TRUE(std::equal(plain.begin(), plain.begin()+500, text.begin()+5000));
+
+        EXPECT_TRUE(reader.seek(4));
+        EXPECT_FALSE(reader.decipher(sealed.data()+3*1016, 1016, plain.data(), false));
+    }
+
+    {
+        // empty object
+        std::vector<uint8_t> empty(ChaCha20Poly1305Stream::sealedSize(0, 1000));
+        EXPECT_EQ(empty.size(), 16u);
+
+        writer.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(writer.encipher(nullptr, 0, empty.data(), true));
+
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(reader.decipher(empty.data(), empty.size(), nullptr, true));
+    }
+
+    {
+        // chunk numbers never wrap: the 2^32nd chunk is the last one a nonce can name
+        const std::uint64_t maxChunks = std::uint64_t{1} << 32;
+        std::vector<uint8_t> out(3*1016, 0xee);
+        const std::vector<uint8_t> untouched = out;
+
+        writer.start(prefix.data(), prefix.size());
+        EXPECT_FALSE(writer.seek(maxChunks));
+        EXPECT_FALSE(writer.encipher(text.data(), 1000, out.data(), true));
+        EXPECT_EQ(out, untouched);
+
+        EXPECT_TRUE(writer.seek(maxChunks - 1));
+        EXPECT_FALSE(writer.encipher(text.data(), 2000, out.data(), false));
+        EXPECT_EQ(out, untouched);
+
+        EXPECT_TRUE(writer.seek(maxChunks - 1));
+        EXPECT_TRUE(writer.encipher(text.data(), 1000, out.data(), false));
+        EXPECT_FALSE(writer.encipher(text.data(), 10, out.data() + 1016, true));
+        EXPECT_TRUE(std::equal(out.begin() + 1016, out.end(), untouched.begin() + 1016));
+
+        // nothing after the last chunk, nor a partial chunk in the middle
+        writer.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(writer.encipher(text.data(), 10, out.data(), true));
+        EXPECT_FALSE(writer.encipher(text.data(), 10, out.data(), true));
+        writer.start(prefix.data(), prefix.size());
+        EXPECT_FALSE(writer.encipher(text.data(), 10, out.data(), false));
+
+        // the one sealed as chunk 2^32-1 opens there
+        std::vector<uint8_t> plain(1000);
+        writer.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(writer.seek(maxChunks - 1));
+        EXPECT_TRUE(writer.encipher(text.data(), 1000, out.data(), true));
+        reader.start(prefix.data(), prefix.size());
+        EXPECT_TRUE(reader.seek(maxChunks - 1));
+        EXPECT_TRUE(reader.decipher(out.data(), 1016, plain.data(), true));
+        EXPECT_TRUE(std::equal(plain.begin(), plain.end(), text.begin()));
+    }
+}
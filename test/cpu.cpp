@@ -0,0 +1,163 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include <dci/crypto.hpp>
+#include <dci/utils/h2b.hpp>
+#include <string>
+#include <tuple>
+
+using namespace dci::crypto;
+using namespace dci::utils;
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(crypto, cpu)
+{
+    const cpu::Tier initial = cpu::activeTier();
+    EXPECT_LE(initial, cpu::detectedTier());
+
+    // masks reach the kernels a better extension shadows: avx2 sha-256 behind sha-ni, avx2 lanes
+    // behind avx512 ones
+    for(const char* mask : {"", "sha", "sha,avx512f"})
+    {
+        cpu::maskFeatures(mask);
+        for(const auto& [primitive, kernel] : cpu::activeKernels())
+        {
+            EXPECT_TRUE(!*mask || kernel != "shani");
+        }
+
+        for(cpu::Tier tier : {cpu::Tier::generic, cpu::Tier::ssse3, cpu::Tier::avx2, cpu::Tier::avx512})
+        {
+            cpu::forceTier(tier);
+            EXPECT_EQ(cpu::activeTier(), std::min(tier, cpu::detectedTier()));
+            EXPECT_FALSE(cpu::activeKernels().empty());
+
+            std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+            std::vector<uint8_t> iv = h2b("00000090000000a400000000");
+            std::vector<uint8_t> stream(4096);
+
+            ChaCha h;
+            h.setKey(key.data(), key.size());
+            h.setIv(iv.data(), iv.size());
+            h.cipher(nullptr, stream.data(), 100);
+            h.cipher(nullptr, stream.data()+100, stream.size()-100);
+
+            std::vector<uint8_t> digest(32);
+            sha2_256(stream.data(), stream.size(), digest.data());
+            EXPECT_EQ(b2h(digest.data(), digest.size()), "8d1b48fe6bbc83c2121d59101d867d7ff3b06433a719160ba8c4b80239958d7e");
+
+            // sha-512: the generic transform, the ssse3 schedule at its tier, avx2 above
+            {
+                std::vector<uint8_t> digest512(64);
+                sha2_512(stream.data(), stream.size(), digest512.data());
+                EXPECT_EQ(b2h(digest512.data(), digest512.size()), "e28e6920758c973558325bb042e7ea0a14ff02f1a987d3188cc1b7b62cdc50f109668bab60e4ecb6a8902ff3dc53da7205dd85011d6777cd50d3c7d1a0566831");
+
+                const std::string fips = "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+                sha2_512(fips.data(), fips.size(), digest512.data());
+                EXPECT_EQ(b2h(digest512.data(), digest512.size()), "e859b957ad3e31adc84f7f8241cf41f3f877976cbef9f71a2799eada6b88098105d182e994007f4e33b199ed4c5b34a37c3d92ee6bdd6245e5695eb578b49e90");
+            }
+
+            // lane kernels against the single message one
+            std::vector<Sha2_256Job> jobs(19);
+            std::vector<std::vector<uint8_t>> digests(jobs.size(), std::vector<uint8_t>(32));
+            std::vector<std::vector<uint8_t>> expected(jobs.size(), std::vector<uint8_t>(32));
+            for(std::size_t i(0); i<jobs.size(); ++i)
+            {
+                const std::size_t len = 200*i + i%3;
+                sha2_256(stream.data() + i, len, expected[i].data());
+                jobs[i] = Sha2_256Job{stream.data() + i, len, digests[i].data()};
+            }
+            Sha2_256::hashBatch(jobs.data(), jobs.size());
+            EXPECT_EQ(digests, expected);
+
+            // the 4-way avx2 poly1305 is bound at the avx2 tier, below ifma
+            {
+                std::vector<uint8_t> ones(16*600, 0xff);
+                std::vector<uint8_t> mac(16);
+
+                Poly1305 p;
+                p.setKey(ones.data(), 32);
+                p.add(ones.data(), ones.size());
+                p.finish(mac.data());
+                EXPECT_EQ(mac, h2b("72bef37a7be1db17dc4307baf62bbf2a"));
+            }
+
+            // rfc 8439 a.3 carry edge cases, short enough for the scalar kernels alone: the 44-bit
+            // generic one at the generic tier, mulx above it
+            {
+                const auto block = [](uint8_t first, uint8_t rest)
+                {
+                    std::vector<uint8_t> res(16, rest);
+                    res[0] = first;
+                    return res;
+                };
+
+                const auto check = [&](uint8_t r, uint8_t s, std::initializer_list<std::vector<uint8_t>> blocks, const std::vector<uint8_t>& tag)
+                {
+                    std::vector<uint8_t> key(32, s);
+                    std::fill(key.begin(), key.begin()+16, 0);
+                    key[0] = r;
+
+                    std::vector<uint8_t> text;
+                    for(const std::vector<uint8_t>& b : blocks)
+                    {
+                        text.insert(text.end(), b.begin(), b.end());
+                    }
+
+                    std::vector<uint8_t> mac(16);
+                    Poly1305 p;
+                    p.setKey(key.data(), key.size());
+                    p.add(text.data(), text.size());
+                    p.finish(mac.data());
+                    EXPECT_EQ(mac, tag);
+                };
+
+                check(2, 0x00, {block(0xff, 0xff)}, block(0x03, 0x00));
+                check(2, 0xff, {block(0x02, 0x00)}, block(0x03, 0x00));
+                check(1, 0x00, {block(0xff, 0xff), block(0xf0, 0xff), block(0x11, 0x00)}, block(0x05, 0x00));
+                check(1, 0x00, {block(0xff, 0xff), block(0xfb, 0xfe), block(0x01, 0x01)}, block(0x00, 0x00));
+                check(2, 0x00, {block(0xfd, 0xff)}, block(0xfa, 0xff));
+            }
+
+            // gcm spec test cases 4, 10 and 16: the table sbox, key schedule and bitwise ghash at
+            // the generic tier, aes-ni and pclmul above it
+            {
+                std::vector<uint8_t> gcmKey = h2b("efff9e29685637c1d6a6f84976033880efff9e29685637c1d6a6f84976033880");
+                std::vector<uint8_t> nonce = h2b("acefabebafecbddaedac8f88");
+                std::vector<uint8_t> ad = h2b("efdeafeceddaebfeefdeafeceddaebfebadaad2d");
+                std::vector<uint8_t> plain = h2b("9d1323528f48605e5a95905cfa5f62a9687a9a3551437fade2c403d3a813a827c1c3c05959869035f2fce042946a5b521ba6de5faad06e75ab36b793");
+
+                for(const auto& [keyLen, cipher, tag] : {
+                    std::tuple<std::size_t, const char*, const char*>{16, "2438e12c12774742b427127b480d4dc93eaa12f2c2204a0e531ce73292ca1ae2125d412b456639c1d7f8a6a5ca48aa50b13ab093a6a0ca79d3850e19", "b59cf4cb23125abd49af9ea57e21a174"},
+                    std::tuple<std::size_t, const char*, const char*>{24, "9308acb0c3008e14be60af4c78a2727558e9c1ae6afe9d482658394bc01a1ec9d777d3001c445c52ca16d9818ca4f374812e44b8f23e429dccad7201", "529194e8081f74f873ab55dbd67216c8"},
+                    std::tuple<std::size_t, const char*, const char*>{32, "25d21c0f9965d7704ff7733aa24824d746a3c8cdfb5e0c9c57892adb52551daac80be88495d0bbd37a0bb801652888835c6fe13639aba7a0cb9c6f26", "67cfe6ecf0e47186dcfd8835bbd255b1"}})
+                {
+                    std::vector<uint8_t> text = plain;
+                    std::vector<uint8_t> mac(16);
+
+                    AesGcm a;
+                    a.setKey(gcmKey.data(), keyLen);
+                    a.setAd(ad.data(), ad.size());
+                    a.start(nonce.data(), nonce.size());
+                    EXPECT_TRUE(a.encipher(text.data(), text.data(), text.size()));
+                    a.encipherFinish(mac.data());
+                    EXPECT_EQ(b2h(text.data(), text.size()), cipher);
+                    EXPECT_EQ(b2h(mac.data(), mac.size()), tag);
+
+                    a.start(nonce.data(), nonce.size());
+                    EXPECT_TRUE(a.decipher(text.data(), text.data(), text.size()));
+                    EXPECT_TRUE(a.decipherFinish(mac.data()));
+                    EXPECT_EQ(text, plain);
+                }
+            }
+        }
+    }
+
+    cpu::maskFeatures("");
+    cpu::forceTier(initial);
+    EXPECT_EQ(cpu::activeTier(), initial);
+}
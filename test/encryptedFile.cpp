@@ -0,0 +1,143 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include <dci/crypto.hpp>
+#include <dci/utils/b2h.hpp>
+#include <dci/utils/h2b.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using namespace dci::crypto;
+using namespace dci::utils;
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(crypto, encryptedFile)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "dci-crypto-encryptedFile.test").string();
+    std::vector<uint8_t> key = h2b("00102030405060708090a0b0c0d0e0f001112131415161718191a1b1c1d1e1f1");
+
+    std::vector<uint8_t> text(300000);
+    for(std::size_t i(0); i<text.size(); ++i)
+    {
+        text[i] = static_cast<uint8_t>(i*7 + (i>>8));
+    }
+
+    {
+        // uneven writes: staged, whole segments at once, the short last one
+        EncryptedFile f;
+        EXPECT_TRUE(f.create(path.c_str(), key.data(), key.size(), text.size(), 4096));
+        EXPECT_TRUE(f.write(text.data(), 1000));
+        EXPECT_TRUE(f.write(text.data()+1000, 100000));
+        EXPECT_TRUE(f.write(text.data()+101000, text.size()-101000));
+        EXPECT_FALSE(f.write(text.data(), 1));
+        EXPECT_TRUE(f.close());
+    }
+
+    EXPECT_EQ(std::filesystem::file_size(path), EncryptedFile::headerSize + ChaCha20Poly1305Stream::sealedSize(text.size(), 4096));
+
+    {
+        EncryptedFile f;
+        EXPECT_TRUE(f.open(path.c_str(), key.data(), key.size()));
+        EXPECT_EQ(f.size(), text.size());
+
+        for(std::pair<std::size_t, std::size_t> range : {std::pair<std::size_t, std::size_t>{0, 0}, {0, 10}, {4090, 10}, {4096, 4096}, {5000, 50000}, {299990, 10}, {290000, 10000}, {0, 300000}})
+        {
+            std::vector<uint8_t> part(range.second);
+            EXPECT_TRUE(f.read(range.first, part.data(), part.size()));
+            EXPECT_TRUE(std::equal(part.begin(), part.end(), text.begin() + static_cast<std::ptrdiff_t>(range.first)));
+        }
+
+        std::vector<uint8_t> part(10);
+        EXPECT_FALSE(f.read(299995, part.data(), part.size()));
+        EXPECT_TRUE(f.close());
+    }
+
+    {
+        // a forged segment fails only the reads that touch it
+        {
+            std::fstream s(path, std::ios::in | std::ios::out | std::ios::binary);
+            const std::streamoff at = static_cast<std::streamoff>(EncryptedFile::headerSize + 10*(4096+16) + 100);
+            s.seekg(at);
+            const char c = static_cast<char>(s.get() ^ 1);
+            s.seekp(at);
+            s.put(c);
+        }
+
+        EncryptedFile f;
+        EXPECT_TRUE(f.open(path.c_str(), key.data(), key.size()));
+
+        std::vector<uint8_t> part(5000);
+        EXPECT_FALSE(f.read(10*4096 + 1000, part.data(), 10));
+        EXPECT_FALSE(f.read(9*4096, part.data(), part.size()));
+        EXPECT_TRUE(f.read(8*4096, part.data(), part.size()));
+        EXPECT_TRUE(std::equal(part.begin(), part.end(), text.begin() + 8*4096));
+        EXPECT_TRUE(f.read(11*4096, part.data(), part.size()));
+        EXPECT_TRUE(std::equal(part.begin(), part.end(), text.begin() + 11*4096));
+    }
+
+    {
+        // a changed header breaks every segment
+        {
+            std::fstream s(path, std::ios::in | std::ios::out | std::ios::binary);
+            s.seekg(12);
+            const char c = static_cast<char>(s.get() ^ 1);
+            s.seekp(12);
+            s.put(c);
+        }
+
+        EncryptedFile f;
+        EXPECT_TRUE(f.open(path.c_str(), key.data(), key.size()));
+
+        std::vector<uint8_t> part(10);
+        EXPECT_FALSE(f.read(0, part.data(), part.size()));
+    }
+
+    {
+        EncryptedFile f;
+        EXPECT_TRUE(f.create(path.c_str(), key.data(), key.size(), 0));
+        EXPECT_TRUE(f.close());
+
+        EXPECT_TRUE(f.open(path.c_str(), key.data(), key.size()));
+        EXPECT_EQ(f.size(), 0u);
+        EXPECT_TRUE(f.read(0, nullptr, 0));
+    }
+
+    {
+        EncryptedFile f;
+        EXPECT_TRUE(f.create(path.c_str(), key.data(), key.size(), 100));
+        EXPECT_TRUE(f.write(text.data(), 50));
+
+        // a partly written segment is not staged in the file
+        {
+            std::ifstream s(path, std::ios::binary);
+            const std::vector<uint8_t> content((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+            EXPECT_TRUE(std::search(content.begin(), content.end(), text.begin(), text.begin() + 50) == content.end());
+        }
+
+        EXPECT_FALSE(f.close());
+    }
+
+    {
+        // a header whose sizes wrap around 64 bits must not pass for a 15 byte body
+        {
+            std::ofstream s(path, std::ios::binary | std::ios::trunc);
+            std::string header(47, '\0');
+            header.replace(0, 8, "dci.seg1");
+            header.replace(8, 4, 4, '\xff');
+            header.replace(20, 8, 8, '\xff');
+            s.write(header.data(), static_cast<std::streamsize>(header.size()));
+        }
+
+        EncryptedFile f;
+        EXPECT_FALSE(f.open(path.c_str(), key.data(), key.size()));
+    }
+
+    std::filesystem::remove(path);
+}
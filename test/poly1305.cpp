@@ -32,4 +32,50 @@ TEST(crypto, poly1305)
         h.finish(digest.data());
         EXPECT_EQ(digest, h2b("f690f6fdc3f27b60b12fbf2423fc21ad"));
     }
+
+    {
+        // long input takes the vector path, short pieces the scalar one
+        std::vector<uint8_t> key(32), text(1000);
+        for(std::size_t i(0); i<key.size(); ++i)
+        {
+            key[i] = static_cast<uint8_t>(0xff - i);
+        }
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*13);
+        }
+
+        Poly1305 bulk, piecewise;
+        bulk.setKey(key.data(), key.size());
+        piecewise.setKey(key.data(), key.size());
+
+        bulk.add(text.data(), text.size());
+        for(std::size_t i(0); i<text.size(); i += 15)
+        {
+            piecewise.add(text.data()+i, std::min(std::size_t{15}, text.size()-i));
+        }
+
+        std::vector<uint8_t> expected(16);
+        bulk.finish(digest.data());
+        piecewise.finish(expected.data());
+        EXPECT_EQ(digest, expected);
+        EXPECT_EQ(digest, h2b("a8b9473a485f3b02fda21ff8a8843f7d"));
+    }
+
+    {
+        // all ones in key and message drive every limb to its carry bounds, for hundreds of blocks
+        std::vector<uint8_t> key(32, 0xff);
+        for(const auto& [len, mac] : {std::pair<std::size_t, const char*>{16*37, "3585530a707ae9c3cd85ab1b03fb7b96"},
+                                      std::pair<std::size_t, const char*>{16*600, "72bef37a7be1db17dc4307baf62bbf2a"},
+                                      std::pair<std::size_t, const char*>{16*600+15, "3e92f2e3c93e6c03036698353b0d9762"}})
+        {
+            std::vector<uint8_t> text(len, 0xff);
+
+            Poly1305 h;
+            h.setKey(key.data(), key.size());
+            h.add(text.data(), text.size());
+            h.finish(digest.data());
+            EXPECT_EQ(digest, h2b(mac));
+        }
+    }
 }
@@ -29,4 +29,76 @@ TEST(crypto, sha2_256)
         h.finish(digest.data());
         EXPECT_EQ(digest, h2b("7d8abf3b707d084996aca9cb0b80e2f4d865154ed6c3bd67d2200dfb739c5e29"));
     }
+
+    {
+        Sha2_256 h;
+        h.add("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq");
+        h.finish(digest.data());
+        EXPECT_EQ(digest, h2b("42d8a6162d60838b5e0c6239c0e306933ac34e9546ff12766fcede4d91bd601c"));
+    }
+
+    {
+        Sha2_256 h;
+        std::string text(1000000, 'a');
+        h.add(text.data(), text.size());
+        h.finish(digest.data());
+        EXPECT_EQ(digest, h2b("dc7ce6c59941bf29181a7c2e487de3761f08a9844a7902e040d693cc7c11c20d"));
+    }
+
+    {
+        std::vector<uint8_t> text(5000);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*7);
+        }
+
+        for(std::size_t step : {std::size_t{1}, std::size_t{63}, std::size_t{64}, std::size_t{65}, std::size_t{1000}})
+        {
+            Sha2_256 h;
+            for(std::size_t i(0); i<text.size(); i += step)
+            {
+                h.add(text.data()+i, std::min(step, text.size()-i));
+            }
+            h.finish(digest.data());
+            EXPECT_EQ(digest, h2b("0bba1ecf2312843869bc48b537ad2d0a38983238d7df7642b7605e69ff3f2f3c"));
+        }
+    }
+
+    {
+        std::vector<uint8_t> text(3000);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*13);
+        }
+
+        // uneven lengths around the padding edges, some long ones to keep lanes busy
+        std::vector<std::size_t> lens;
+        for(std::size_t len(0); len<=130; ++len)
+        {
+            lens.push_back(len);
+        }
+        for(std::size_t len : {std::size_t{1024}, std::size_t{3000}, std::size_t{32}, std::size_t{2999}})
+        {
+            lens.push_back(len);
+        }
+
+        std::vector<Sha2_256Job> jobs(lens.size());
+        std::vector<std::vector<uint8_t>> digests(lens.size());
+        std::vector<std::vector<uint8_t>> expected(lens.size());
+        for(std::size_t i(0); i<lens.size(); ++i)
+        {
+            const std::size_t digestSize = i%5 ? 32 : 16;
+            digests[i].resize(digestSize);
+            expected[i].resize(digestSize);
+            sha2_256(text.data() + i, std::min(lens[i], text.size() - i), expected[i].data(), digestSize);
+            jobs[i] = Sha2_256Job{text.data() + i, std::min(lens[i], text.size() - i), digests[i].data(), digestSize};
+        }
+
+        Sha2_256::hashBatch(jobs.data(), jobs.size());
+        EXPECT_EQ(digests, expected);
+
+        Sha2_256::hashBatch(jobs.data(), 3);
+        Sha2_256::hashBatch(jobs.data(), 0);
+        EXPECT_EQ(digests, expected);
+    }
 }
@@ -29,4 +29,39 @@ TEST(crypto, sha2_512)
         h.finish(digest.data());
         EXPECT_EQ(digest, h2b("705e749d85f6a6377ff3ab0c34e57d961512f87b0d8c7d883a907d5834b6bb46e2392a259a452f932145d7e1a8b3e56d1efb7d90871232f30a35f8d38b45ef6e"));
     }
+
+    {
+        // 112 bytes, the padding and the 128-bit length no longer fit the block
+        Sha2_512 h;
+        h.add("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu");
+        h.finish(digest.data());
+        EXPECT_EQ(digest, h2b("e859b957ad3e31adc84f7f8241cf41f3f877976cbef9f71a2799eada6b88098105d182e994007f4e33b199ed4c5b34a37c3d92ee6bdd6245e5695eb578b49e90"));
+    }
+
+    {
+        Sha2_512 h;
+        std::string text(115, 'q');
+        h.add(text.data(), text.size());
+        h.finish(digest.data());
+        EXPECT_EQ(digest, h2b("76b303038db2597f6cf2b1c027942b557db6383c70e85017d57a0f57c358ab284a4a027e68636f6ef4a088e600c597f4a726894a05f1ca384c327cd8dbd46bef"));
+    }
+
+    {
+        std::vector<uint8_t> text(5000);
+        for(std::size_t i(0); i<text.size(); ++i)
+        {
+            text[i] = static_cast<uint8_t>(i*7);
+        }
+
+        for(std::size_t step : {std::size_t{1}, std::size_t{127}, std::size_t{128}, std::size_t{129}, std::size_t{384}, std::size_t{5000}})
+        {
+            Sha2_512 h;
+            for(std::size_t i(0); i<text.size(); i += step)
+            {
+                h.add(text.data()+i, std::min(step, text.size()-i));
+            }
+            h.finish(digest.data());
+            EXPECT_EQ(digest, h2b("fe284ac09ffb7df02feb3af125a9500cba4195e85fcc21bb89378907b02f083edb84500f3e4bba29d804c454afeff6315f55a93a2e1217f9c2c437d5a937f977"));
+        }
+    }
 }